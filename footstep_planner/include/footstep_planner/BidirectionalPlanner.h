@@ -0,0 +1,170 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_BIDIRECTIONALPLANNER_H_
+#define FOOTSTEP_PLANNER_BIDIRECTIONALPLANNER_H_
+
+#include <footstep_planner/FootstepPlannerEnvironment.h>
+#include <ros/ros.h>
+#include <sbpl/headers.h>
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief A weighted A* search growing one search tree from the start
+ * (forward) and one from the goal (backward) over the footstep lattice.
+ *
+ * Each expanded state is connected to the states generated by the other
+ * search which can be reached by a single footstep (see
+ * FootstepPlannerEnvironment::getStepCost()). The candidates are found in
+ * a spatial hash of the other search's states with buckets of the maximal
+ * step width. The search expands the side with the smaller OPEN list and
+ * stops once the cheapest connection found is not more expensive than the
+ * larger one of the minimal f-values of the two OPEN lists.
+ *
+ * The search tree towards the environment's search direction uses the
+ * environment's heuristic. The other one uses it as well if the heuristic
+ * estimates the costs between arbitrary states, otherwise a lower bound
+ * of the step costs along the straight line.
+ *
+ * The planner always searches until the first solution and does not reuse
+ * previous searches.
+ */
+class BidirectionalPlanner : public SBPLPlanner
+{
+public:
+  BidirectionalPlanner(FootstepPlannerEnvironment* environment);
+  virtual ~BidirectionalPlanner();
+
+  virtual int replan(double allocated_time_sec,
+                     std::vector<int>* solution_stateIDs_V);
+  virtual int replan(double allocated_time_sec,
+                     std::vector<int>* solution_stateIDs_V, int* solcost);
+  virtual int set_goal(int goal_stateID);
+  virtual int set_start(int start_stateID);
+  virtual int force_planning_from_scratch();
+  virtual int set_search_mode(bool bSearchUntilFirstSolution);
+  virtual void costs_changed(const StateChangeQuery& stateChange);
+
+  virtual double get_solution_eps() const { return ivEps; };
+  virtual int get_n_expands() const { return ivNumExpands; };
+  virtual double get_initial_eps() { return ivEps; };
+  virtual double get_final_epsilon() { return ivEps; };
+  virtual void set_initialsolution_eps(double initialsolution_eps);
+
+private:
+  struct SearchState
+  {
+    SearchState()
+    : g(INFINITECOST), h(-1), f(INFINITECOST), parent(-1), x(0), y(0),
+      leg(NOLEG), closed(false)
+    {};
+
+    int g;
+    int h;
+    int f;
+    /// The state this state has been reached from (in this search).
+    int parent;
+    /// The position of the planning state (in m).
+    double x, y;
+    Leg leg;
+    bool closed;
+  };
+
+  /// OPEN ordered by (f, state ID).
+  typedef std::set<std::pair<int, int> > open_t;
+  /// The IDs of the generated states of one leg per bucket.
+  typedef std::map<std::pair<int, int>, std::vector<int> > spatial_hash_t;
+
+  /// One of the two searches.
+  struct Search
+  {
+    bool forward;
+    /// The state the search starts from (start or goal).
+    int source_id;
+    /// The state the search estimates the costs to (goal or start).
+    int target_id;
+    /// Whether the environment's heuristic estimates the costs to target.
+    bool use_environment_heuristic;
+    /// The position of the target (in m).
+    double target_x, target_y;
+
+    /// The search information of all states (index: state ID).
+    std::vector<SearchState> states;
+    open_t open;
+    /// The generated states (index: leg).
+    spatial_hash_t generated[2];
+  };
+
+  /// @brief Prepares a search from source to target.
+  void initSearch(Search* search, bool forward, int source_id,
+                  int target_id);
+
+  /// @brief Expands the first state of the search's OPEN list.
+  void expandState(Search* search, const Search& other);
+
+  /**
+   * @brief Updates the best solution with the connections of the (expanded)
+   * state 'id' of the search to the states generated by the other search.
+   */
+  void connect(const Search& search, const Search& other, int id);
+
+  /**
+   * @return The information of state 'id' in 'search', its heuristic
+   * estimates the costs to the search's target. NOTE: invalidates previously
+   * returned references of the same search.
+   */
+  SearchState& getSearchState(Search* search, int id);
+
+  /// @return The bucket of the spatial hash containing (x, y) (in m).
+  std::pair<int, int> getBucket(double x, double y) const;
+
+  FootstepPlannerEnvironment* ivEnvironment;
+  double ivEps;
+
+  int ivStartId;
+  int ivGoalId;
+
+  /// The size of the spatial hash's buckets (in m).
+  double ivBucketSize;
+
+  Search ivForwardSearch;
+  Search ivBackwardSearch;
+  int ivNumExpands;
+
+  std::vector<int> ivNeighborIds;
+  std::vector<int> ivNeighborCosts;
+
+  /// The costs of the best connection found so far.
+  int ivSolutionCost;
+  /// The state of the forward search of the best connection.
+  int ivSolutionForwardId;
+  /// The state of the backward search of the best connection.
+  int ivSolutionBackwardId;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_BIDIRECTIONALPLANNER_H_
@@ -0,0 +1,118 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_CELLBITMAP_H_
+#define FOOTSTEP_PLANNER_CELLBITMAP_H_
+
+#include <algorithm>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief A dense set of (x, y) cells within a fixed rectangular extent,
+ * stored as one bit per cell. Cells outside of the extent are ignored.
+ */
+class CellBitmap
+{
+public:
+  CellBitmap()
+  : ivMinX(0),
+    ivMinY(0),
+    ivNumX(0),
+    ivNumY(0)
+  {};
+
+  /**
+   * @brief Sets the extent of the bitmap (the cells [min_x, min_x+num_x) x
+   * [min_y, min_y+num_y)) and removes all cells.
+   */
+  void resize(int min_x, int min_y, int num_x, int num_y)
+  {
+    ivMinX = min_x;
+    ivMinY = min_y;
+    ivNumX = std::max(num_x, 0);
+    ivNumY = std::max(num_y, 0);
+    ivBits.assign((size_t(ivNumX) * ivNumY + 63) / 64, 0);
+  };
+
+  /// @brief Removes all cells (keeps the extent).
+  void clear()
+  {
+    std::fill(ivBits.begin(), ivBits.end(), 0);
+  };
+
+  /// @brief Adds the cell (x, y).
+  void set(int x, int y)
+  {
+    size_t i;
+    if (index(x, y, &i))
+      ivBits[i >> 6] |= uint64_t(1) << (i & 63);
+  };
+
+  /// @return True iff the cell (x, y) has been added.
+  bool test(int x, int y) const
+  {
+    size_t i;
+    if (!index(x, y, &i))
+      return false;
+    return (ivBits[i >> 6] >> (i & 63)) & 1;
+  };
+
+  /// @brief Appends all cells that have been added to 'cells'.
+  void getCells(std::vector<std::pair<int, int> >* cells) const
+  {
+    for (size_t w = 0; w < ivBits.size(); ++w)
+    {
+      uint64_t word = ivBits[w];
+      for (size_t i = w * 64; word != 0; word >>= 1, ++i)
+      {
+        if (word & 1)
+        {
+          cells->push_back(std::pair<int, int>(ivMinX + int(i / ivNumY),
+                                               ivMinY + int(i % ivNumY)));
+        }
+      }
+    }
+  };
+
+  /// @return The memory (in bytes) used by the bitmap.
+  size_t getMemoryUsage() const { return ivBits.size() * sizeof(uint64_t); };
+
+private:
+  bool index(int x, int y, size_t* i) const
+  {
+    x -= ivMinX;
+    y -= ivMinY;
+    if (x < 0 || y < 0 || x >= ivNumX || y >= ivNumY)
+      return false;
+    *i = size_t(x) * ivNumY + y;
+    return true;
+  };
+
+  int ivMinX, ivMinY, ivNumX, ivNumY;
+  std::vector<uint64_t> ivBits;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_CELLBITMAP_H_
@@ -0,0 +1,151 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_CHUNKEDARENA_H_
+#define FOOTSTEP_PLANNER_CHUNKEDARENA_H_
+
+#include <assert.h>
+#include <new>
+#include <stddef.h>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief An arena handing out storage for elements of type T from large
+ * chunks of contiguous memory.
+ *
+ * Elements cannot be freed individually. clear() invalidates all of them
+ * at once but keeps the chunks for reuse, so a subsequent planning task
+ * does not need to allocate memory again. NOTE: the destructors of the
+ * stored elements are never called, i.e. T must not own any resources.
+ */
+template <typename T>
+class ChunkedArena
+{
+public:
+  /// @param chunk_size The number of elements stored in one chunk.
+  explicit ChunkedArena(size_t chunk_size)
+  : ivChunkSize(chunk_size),
+    ivCurrentChunk(0),
+    ivChunkOffset(0),
+    ivNumAllocations(0),
+    ivNumChunkAllocations(0)
+  {
+    assert(ivChunkSize > 0);
+  };
+
+  ~ChunkedArena()
+  {
+    release();
+  };
+
+  /**
+   * @return Uninitialized storage for 'n' consecutive elements (use
+   * placement new to construct objects in it).
+   */
+  T* allocate(size_t n = 1)
+  {
+    assert(n <= ivChunkSize);
+    if (ivChunks.empty() || ivChunkOffset + n > ivChunkSize)
+      nextChunk();
+
+    T* p = ivChunks[ivCurrentChunk] + ivChunkOffset;
+    ivChunkOffset += n;
+    ++ivNumAllocations;
+    return p;
+  };
+
+  /**
+   * @brief Invalidates all elements handed out so far. The allocated chunks
+   * are kept for reuse.
+   */
+  void clear()
+  {
+    ivCurrentChunk = 0;
+    ivChunkOffset = 0;
+    ivNumAllocations = 0;
+  };
+
+  /// @brief Invalidates all elements and frees the allocated chunks.
+  void release()
+  {
+    typename std::vector<T*>::iterator chunk_iter;
+    for (chunk_iter = ivChunks.begin(); chunk_iter != ivChunks.end();
+         ++chunk_iter)
+    {
+      ::operator delete(*chunk_iter);
+    }
+    ivChunks.clear();
+    clear();
+  };
+
+  /// @return The number of allocate() calls since the last clear().
+  size_t getNumAllocations() const { return ivNumAllocations; };
+
+  /// @return The number of chunks currently owned by the arena.
+  size_t getNumChunks() const { return ivChunks.size(); };
+
+  /**
+   * @return The number of chunks requested from the system allocator since
+   * construction (stays constant when chunks are reused).
+   */
+  size_t getNumChunkAllocations() const { return ivNumChunkAllocations; };
+
+  /// @return The memory (in bytes) currently reserved by the arena.
+  size_t getMemoryUsage() const
+  {
+    return ivChunks.size() * ivChunkSize * sizeof(T);
+  };
+
+private:
+  /// Copying is not supported.
+  ChunkedArena(const ChunkedArena&);
+  ChunkedArena& operator=(const ChunkedArena&);
+
+  void nextChunk()
+  {
+    if (!ivChunks.empty())
+      ++ivCurrentChunk;
+    ivChunkOffset = 0;
+
+    if (ivCurrentChunk == ivChunks.size())
+    {
+      ivChunks.push_back(
+          static_cast<T*>(::operator new(ivChunkSize * sizeof(T))));
+      ++ivNumChunkAllocations;
+    }
+  };
+
+  const size_t ivChunkSize;
+
+  std::vector<T*> ivChunks;
+  /// Index of the chunk the next element is taken from.
+  size_t ivCurrentChunk;
+  /// Number of elements already taken from the current chunk.
+  size_t ivChunkOffset;
+
+  size_t ivNumAllocations;
+  size_t ivNumChunkAllocations;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_CHUNKEDARENA_H_
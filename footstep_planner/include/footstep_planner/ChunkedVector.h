@@ -0,0 +1,98 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_CHUNKEDVECTOR_H_
+#define FOOTSTEP_PLANNER_CHUNKEDVECTOR_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief An append-only sequence of elements of type T stored in chunks
+ * which are never moved.
+ *
+ * In contrast to std::vector, appending an element never relocates the
+ * existing ones, so elements can be read by other threads while elements
+ * are appended (the appending itself has to be serialized). clear() keeps
+ * the chunks for reuse.
+ */
+template <typename T>
+class ChunkedVector
+{
+public:
+  ChunkedVector()
+  : ivChunks(cvMaxChunks, static_cast<T*>(NULL)),
+    ivNumChunks(0),
+    ivSize(0)
+  {};
+
+  ~ChunkedVector()
+  {
+    for (size_t i = 0; i < ivNumChunks; ++i)
+      delete[] ivChunks[i];
+  };
+
+  const T& operator[](size_t i) const
+  {
+    return ivChunks[i >> cvChunkBits][i & (cvChunkSize - 1)];
+  };
+
+  void push_back(const T& value)
+  {
+    size_t chunk = ivSize >> cvChunkBits;
+    if (chunk == ivNumChunks)
+    {
+      assert(ivNumChunks < cvMaxChunks);
+      ivChunks[ivNumChunks++] = new T[cvChunkSize];
+    }
+    ivChunks[chunk][ivSize & (cvChunkSize - 1)] = value;
+    ++ivSize;
+  };
+
+  /// @brief Removes all elements (keeps the chunks).
+  void clear() { ivSize = 0; };
+
+  size_t size() const { return ivSize; };
+
+  /// @return The number of elements fitting into the allocated chunks.
+  size_t capacity() const { return ivNumChunks * cvChunkSize; };
+
+private:
+  /// Copying is not supported.
+  ChunkedVector(const ChunkedVector&);
+  ChunkedVector& operator=(const ChunkedVector&);
+
+  /// log2 of the number of elements per chunk.
+  static const int    cvChunkBits = 16;
+  static const size_t cvChunkSize = size_t(1) << cvChunkBits;
+  /// The chunk directory has a fixed size so it is never reallocated.
+  static const size_t cvMaxChunks = size_t(1) << 15;
+
+  std::vector<T*> ivChunks;
+  size_t ivNumChunks;
+  size_t ivSize;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_CHUNKEDVECTOR_H_
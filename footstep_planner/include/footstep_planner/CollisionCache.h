@@ -0,0 +1,150 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_COLLISIONCACHE_H_
+#define FOOTSTEP_PLANNER_COLLISIONCACHE_H_
+
+#include <footstep_planner/helper.h>
+#include <footstep_planner/PlanningState.h>
+#include <gridmap_2d/GridMap2D.h>
+
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief Memoizes the results of collision checks of planning states for
+ * the lifetime of a map.
+ *
+ * Each (cell x, cell y, theta bin, leg) covered by the map is represented
+ * by 2 bits (unknown, free or occupied). The memory is split into pages
+ * which are allocated on first insertion, so only the regions actually
+ * visited by the search use memory. States outside of the map's extent
+ * are not cached.
+ */
+class CollisionCache
+{
+public:
+  /**
+   * @param cell_size The size of each grid cell used to discretize the
+   * robot positions.
+   * @param num_angle_bins The number of bins used to discretize the
+   * robot orientations.
+   */
+  CollisionCache(double cell_size, int num_angle_bins);
+  ~CollisionCache();
+
+  /// @brief Discards all cached results and adapts the extent to the map.
+  void updateMap(gridmap_2d::GridMap2DPtr map);
+
+  /**
+   * @brief Looks up the cached collision check result of s.
+   * @return False iff there is no result for s, i.e. 'occupied' has not
+   * been set.
+   */
+  bool lookup(const PlanningState& s, bool* occupied) const;
+
+  /// @brief Stores the collision check result of s.
+  void insert(const PlanningState& s, bool occupied);
+
+  /// @return The number of lookup() calls since the last statistics reset.
+  unsigned long getNumLookups() const { return ivNumLookups; };
+
+  /// @return The number of successful lookup() calls.
+  unsigned long getNumHits() const { return ivNumHits; };
+
+  /// @return The fraction of successful lookup() calls.
+  double getHitRate() const
+  {
+    return ivNumLookups ? double(ivNumHits) / ivNumLookups : 0.0;
+  };
+
+  /// @return The memory (in bytes) used by the allocated pages.
+  size_t getMemoryUsage() const
+  {
+    return ivNumPagesAllocated * cvPageWords * sizeof(uint64_t);
+  };
+
+  void resetStatistics();
+
+private:
+  enum Entry { UNKNOWN = 0, FREE = 1, OCCUPIED = 2 };
+
+  /// log2 of the number of entries per page.
+  static const int    cvPageBits = 14;
+  /// Number of uint64_t words per page (32 entries per word).
+  static const size_t cvPageWords = (size_t(1) << cvPageBits) / 32;
+
+  /**
+   * @brief Computes the entry index of s.
+   * @return False iff s is outside of the map's extent.
+   */
+  bool index(const PlanningState& s, size_t* i) const
+  {
+    int x = s.getX() - ivMinX;
+    int y = s.getY() - ivMinY;
+    if (x < 0 || y < 0 || x >= ivNumX || y >= ivNumY)
+      return false;
+    *i = ((size_t(x) * ivNumY + y) * ivNumAngleBins + s.getTheta()) * 2 +
+         (s.getLeg() == LEFT ? 1 : 0);
+    return true;
+  };
+
+  const double ivCellSize;
+  const int    ivNumAngleBins;
+
+  /// The extent of the map (discretized in cell size).
+  int ivMinX, ivMinY, ivNumX, ivNumY;
+
+  /// The pages of entries (an empty page is not allocated yet).
+  std::vector<std::vector<uint64_t> > ivPages;
+  size_t ivNumPagesAllocated;
+
+  mutable unsigned long ivNumLookups;
+  mutable unsigned long ivNumHits;
+};
+
+
+inline bool
+CollisionCache::lookup(const PlanningState& s, bool* occupied)
+const
+{
+  ++ivNumLookups;
+
+  size_t i;
+  if (!index(s, &i))
+    return false;
+  const std::vector<uint64_t>& page = ivPages[i >> cvPageBits];
+  if (page.empty())
+    return false;
+
+  size_t j = i & ((size_t(1) << cvPageBits) - 1);
+  int entry = int(page[j >> 5] >> ((j & 31) * 2)) & 3;
+  if (entry == UNKNOWN)
+    return false;
+
+  ++ivNumHits;
+  *occupied = (entry == OCCUPIED);
+  return true;
+}
+}
+
+#endif  // FOOTSTEP_PLANNER_COLLISIONCACHE_H_
@@ -0,0 +1,152 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_COLLISIONLAYERS_H_
+#define FOOTSTEP_PLANNER_COLLISIONLAYERS_H_
+
+#include <footstep_planner/helper.h>
+#include <gridmap_2d/GridMap2D.h>
+
+#include <boost/thread/mutex.hpp>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief Precomputed configuration space of the robot's foot: one binary
+ * layer per (discretized) orientation and leg, marking every map cell in
+ * which the foot's origin can not be placed without a collision.
+ *
+ * A layer is computed by eroding the free space of the binary map with the
+ * rotated foot rectangle (including the shift of the foot's origin and
+ * inflated by one map cell as done in collision_check()). Afterwards a
+ * collision check is a single bit lookup. The layers are built lazily on
+ * first access or all at once (in parallel) by buildAll(). Layers exceeding
+ * the memory limit are not built at all; for those lookup() fails and the
+ * caller has to fall back to collision_check().
+ */
+class CollisionLayers
+{
+public:
+  /**
+   * @param footsize_x Size of the foot in x direction.
+   * @param footsize_y Size of the foot in y direction.
+   * @param foot_origin_shift_x Shift in x direction from the foot's center.
+   * @param foot_origin_shift_y Shift in y direction from the foot's center.
+   * @param num_angle_bins The number of bins used to discretize the
+   * robot orientations.
+   * @param max_memory The maximal memory (in bytes) used by all layers.
+   */
+  CollisionLayers(double footsize_x, double footsize_y,
+                  double foot_origin_shift_x, double foot_origin_shift_y,
+                  int num_angle_bins, size_t max_memory);
+  ~CollisionLayers();
+
+  /// @brief Discards all layers and sets the map used to build new ones.
+  void updateMap(gridmap_2d::GridMap2DPtr map);
+
+  /**
+   * @brief Builds all layers which are not built yet (as far as the memory
+   * limit allows) using num_threads threads.
+   */
+  void buildAll(int num_threads);
+
+  /**
+   * @brief Looks up whether a foot with its origin at the (continuous)
+   * position (x, y) and the (discretized) orientation theta is colliding.
+   * Builds the respective layer if necessary.
+   *
+   * @return False iff the layer is not available (memory limit reached),
+   * i.e. 'occupied' has not been set.
+   */
+  bool lookup(double x, double y, int theta, Leg leg, bool* occupied);
+
+  /**
+   * @return The number of layers built (or reserved to be built) for the
+   * current map.
+   */
+  int getNumLayersBuilt() const
+  {
+    return __atomic_load_n(&ivNumLayersBuilt, __ATOMIC_RELAXED);
+  };
+
+  /// @return The memory (in bytes) used by the layers of the current map.
+  size_t getMemoryUsage() const
+  {
+    return getNumLayersBuilt() * ivLayerSize * sizeof(uint64_t);
+  };
+
+private:
+  struct Layer
+  {
+    Layer() : built(false) {};
+
+    /**
+     * Set (with release semantics) once 'bits' is complete; lookups read it
+     * with acquire semantics as they do not lock the mutex.
+     */
+    bool built;
+    /// One bit per map cell (index: x * height + y), set if occupied.
+    std::vector<uint64_t> bits;
+  };
+
+  /// @return The index of the layer for the orientation theta and leg.
+  size_t layerIndex(int theta, Leg leg) const
+  {
+    // left and right foot only differ by the sign of the y shift
+    if (ivFootOriginShiftY == 0.0)
+      leg = RIGHT;
+    return size_t(theta) * 2 + (leg == LEFT ? 1 : 0);
+  };
+
+  /**
+   * @brief Reserves memory for the layer 'index' (if the memory limit
+   * allows it).
+   * @return True iff the layer has to be built by the caller.
+   */
+  bool reserveLayer(size_t index);
+
+  /// @brief Computes the layer 'index' (memory has to be reserved before).
+  void buildLayer(size_t index);
+
+  /// @brief Worker loop of buildAll().
+  void buildLayers(const std::vector<size_t>* indices, size_t* next_index);
+
+  const double ivFootsizeX;
+  const double ivFootsizeY;
+  const double ivFootOriginShiftX;
+  const double ivFootOriginShiftY;
+  const int    ivNumAngleBins;
+  const size_t ivMaxMemory;
+
+  gridmap_2d::GridMap2DPtr ivMapPtr;
+
+  std::vector<Layer> ivLayers;
+  /// Number of uint64_t words per layer.
+  size_t ivLayerSize;
+  /// Modified under the mutex, read atomically without it.
+  int ivNumLayersBuilt;
+
+  boost::mutex ivMutex;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_COLLISIONLAYERS_H_
@@ -50,10 +50,9 @@ public:
    * PlanningState for further explanation).
    * @param num_angle_bins Parameter to discretize the rotation (see
    * PlanningState for further explanation).
-   * @param max_hash_size The maximal hash size.
    */
   Footstep(double x, double y, double theta,
-           double cell_size, int num_angle_bins, int max_hash_size);
+           double cell_size, int num_angle_bins);
   ~Footstep();
 
   /**
@@ -77,9 +76,6 @@ public:
   PlanningState reverseMeOnThisState(const PlanningState& current) const;
 
 private:
-  /// Typedef representing the (discretized) translation of the footstep.
-  typedef std::pair<int, int> footstep_xy;
-
   /// Initialization method called within the constructor.
   void init(double x, double y);
 
@@ -112,17 +108,22 @@ private:
   /// The parameter for the discretization of the rotation.
   int ivNumAngleBins;
 
-  /// The maximal hash size.
-  int ivMaxHashSize;
+  /// @return The index of a planning state in the key delta tables.
+  static size_t deltaIndex(const PlanningState& s)
+  {
+    return size_t(s.getKey() &
+                  ((uint64_t(1) << (STATE_KEY_THETA_BITS +
+                                    STATE_KEY_LEG_BITS)) - 1));
+  };
 
-  /// The (discretized) translation(s) for a left supporting foot.
-  std::vector<footstep_xy> ivDiscSuccessorLeft;
-  /// The (discretized) translation(s) for a right supporting foot.
-  std::vector<footstep_xy> ivDiscSuccessorRight;
-  /// The reversed (discretized) translation(s) for a left supporting foot.
-  std::vector<footstep_xy> ivDiscPredecessorLeft;
-  /// The reversed (discretized) translation(s) for a right supporting foot.
-  std::vector<footstep_xy> ivDiscPredecessorRight;
+  /**
+   * @brief The changes of the packed state key (see
+   * calc_state_key_delta()) when performing the footstep, indexed by the
+   * (discretized) orientation and the supporting leg (see deltaIndex()).
+   */
+  std::vector<uint64_t> ivSuccessorKeyDelta;
+  /// The changes of the packed state key when reversing the footstep.
+  std::vector<uint64_t> ivPredecessorKeyDelta;
 };
 } // end of namespace
 
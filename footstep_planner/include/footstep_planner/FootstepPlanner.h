@@ -26,9 +26,11 @@
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
 #include <humanoid_nav_msgs/PlanFootsteps.h>
+#include <footstep_planner/BidirectionalPlanner.h>
 #include <footstep_planner/helper.h>
 #include <footstep_planner/PathCostHeuristic.h>
 #include <footstep_planner/FootstepPlannerEnvironment.h>
+#include <footstep_planner/PASEPlanner.h>
 #include <footstep_planner/PlanningStateChangeQuery.h>
 #include <footstep_planner/State.h>
 #include <nav_msgs/Path.h>
@@ -41,6 +43,8 @@
 #include <XmlRpcValue.h>
 #include <XmlRpcException.h>
 
+#include <boost/function.hpp>
+
 #include <assert.h>
 #include <time.h>
 
@@ -49,6 +53,19 @@ namespace footstep_planner
 {
 typedef std::vector<State>::const_iterator state_iter_t;
 
+/// @brief An improved solution of an anytime search.
+struct anytime_solution
+{
+  /// The costs of the path.
+  double cost;
+  /// The suboptimality bound of the path.
+  double eps;
+  /// The number of states expanded so far.
+  int expanded_states;
+  /// The time since the start of the planning task (in s).
+  double time;
+};
+
 /**
  * @brief A class to control the interaction between ROS and the footstep
  * planner.
@@ -132,6 +149,18 @@ public:
    */
   bool updateMap(const gridmap_2d::GridMap2DPtr map);
 
+  /**
+   * @brief Sets a function called with each improved solution while the
+   * ARAPlanner's solutions are streamed (see anytime_streaming). The
+   * planned path (getPathBegin(), getPathEnd()) already contains the new
+   * solution when the function is called.
+   */
+  void setSolutionCallback(
+      const boost::function<void (const anytime_solution&)>& callback)
+  {
+    ivSolutionCallback = callback;
+  };
+
   void setMarkerNamespace(const std::string& ns)
   {
     ivMarkerNamespace = ns;
@@ -206,6 +235,22 @@ public:
   /// @brief Reset and reinitialize the environment.
   void resetTotally();
 
+  /**
+   * @brief Reset the previous search but keep the planning states (and
+   * thereby the cached collision checks and heuristic values) for the
+   * next planning task. Falls back to reset() if the environment uses
+   * more than ivWarmStartMaxMemory.
+   */
+  void resetSearch();
+
+  /**
+   * @brief Computes the StepCostTable of the configured footsteps within
+   * 'radius' (in m) around the goal and writes it to 'filename'.
+   *
+   * @return True if the table has been written successfully.
+   */
+  bool saveStepCostTable(const std::string& filename, double radius);
+
   /// @return True if for the current start and goal pose a path exists.
   bool pathExists() { return (bool)ivPath.size(); };
 
@@ -231,6 +276,18 @@ protected:
    */
   bool extractPath(const std::vector<int>& state_ids);
 
+  /**
+   * @return False if a foot pose of the path collides (only necessary with
+   * lazy collision checks).
+   */
+  bool pathIsCollisionFree() const;
+
+  /**
+   * @brief Extracts, publishes and reports (see setSolutionCallback()) an
+   * improved solution of the anytime search.
+   */
+  void streamSolution(const std::vector<int>& state_ids, int path_cost);
+
   /// @brief Generates a visualization msgs for a foot pose.
   void footPoseToMarker(const State& footstep,
                         visualization_msgs::Marker* marker);
@@ -243,14 +300,58 @@ protected:
    */
   bool run();
 
+  /**
+   * @brief Runs the SBPL planner from the environment's start to its goal
+   * state for at most 'max_time' seconds.
+   *
+   * @return The result of the SBPL planner (0 on failure).
+   */
+  int search(const MDPConfig& mdp_config, double max_time,
+             std::vector<int>* solution_state_ids, int* path_cost);
+
+  /**
+   * @brief Plans on the coarse lattice (see ivCoarseEnvironmentPtr) until
+   * the first solution is found.
+   *
+   * @param path The (x, y) positions of the coarse foot poses.
+   * @return True if a coarse path has been found.
+   */
+  bool planCoarse(std::vector<std::pair<double, double> >* path);
+
+  /**
+   * @brief Discretizes the footsteps and the step range with the cell size
+   * and the number of angle bins of 'params'.
+   */
+  void discretizeFootsteps(environment_params* params) const;
+
+  /// @brief Creates the configured heuristic for the lattice of 'params'.
+  boost::shared_ptr<Heuristic> createHeuristic(
+      const environment_params& params) const;
+
+  /**
+   * @brief Extracts the 2D path of the PathCostHeuristic between start and
+   * goal (see PathCostHeuristic::getPath()).
+   *
+   * @return False if no PathCostHeuristic is used or no path exists.
+   */
+  bool getHeuristicPath(std::vector<std::pair<double, double> >* path) const;
+
   /// @brief Returns the foot pose of a leg for a given robot pose.
   State getFootPose(const State& robot, Leg side);
 
   /// @brief Sets the planning algorithm used by SBPL.
   void setPlanner();
 
-  /// @brief Updates the environment in case of a changed map.
-  void updateEnvironment(const gridmap_2d::GridMap2DPtr old_map);
+  /**
+   * @brief Updates the environment in case of a changed map. When using
+   * the AD planner and the geometry of the maps is identical, the planner
+   * is only informed about the states affected by the changed cells (as
+   * long as there are at most ivChangedCellsLimit of them), otherwise the
+   * planning information is reset.
+   *
+   * @return True if a replanning is necessary (i.e. the map has changed).
+   */
+  bool updateEnvironment(const gridmap_2d::GridMap2DPtr old_map);
 
   boost::shared_ptr<FootstepPlannerEnvironment> ivPlannerEnvironmentPtr;
   gridmap_2d::GridMap2DPtr ivMapPtr;
@@ -258,6 +359,41 @@ protected:
 
   boost::shared_ptr<const PathCostHeuristic> ivPathCostHeuristicPtr;
 
+  /// Whether to restrict the search to a corridor around a coarse path.
+  bool ivHierarchical;
+  /// Environment of the coarse planning stage (NULL if not used).
+  boost::shared_ptr<FootstepPlannerEnvironment> ivCoarseEnvironmentPtr;
+  environment_params ivCoarseEnvironmentParams;
+  /// Half width of the corridor around the coarse path (in m).
+  double ivCorridorWidth;
+  /// Maximal search time of the coarse planning stage.
+  double ivCoarseSearchTime;
+  /**
+   * Whether to restrict the search to a corridor around the 2D path of the
+   * PathCostHeuristic (if not planning hierarchically).
+   */
+  bool ivHeuristicCorridor;
+  /// Half width of the corridor around the 2D path (in m).
+  double ivHeuristicCorridorWidth;
+  /**
+   * Width up to which a corridor is doubled if no solution is found within
+   * it; beyond that the search is not restricted any more.
+   */
+  double ivMaxCorridorWidth;
+
+  /// The (continuous) footsteps as (x, y, theta).
+  std::vector<State> ivFootsteps;
+  /// The (continuous) polygon of performable steps.
+  std::vector<std::pair<double, double> > ivStepRange;
+
+  std::string ivHeuristicType;
+  double ivDiffAngleCost;
+  /// The maximal translation of the footsteps.
+  double ivMaxFootstepWidth;
+  int    ivHeuristicCacheSize;
+  int    ivHeuristicCacheMaxMemory;
+  int    ivHeuristicThreads;
+
   std::vector<State> ivPath;
 
   State ivStartFootLeft;
@@ -291,6 +427,26 @@ protected:
    */
    int ivChangedCellsLimit;
 
+  /// Whether to keep the planning states across planning tasks.
+  bool ivWarmStart;
+  /**
+   * @brief High-water mark of the environment's memory (in MB) up to which
+   * the planning states are kept.
+   */
+  int ivWarmStartMaxMemory;
+
+  /// Number of threads expanding states (PASEPlanner).
+  int ivPASEThreads;
+  /// Factor of the independence check (PASEPlanner).
+  double ivPASEIndependenceEps;
+
+  /// Whether to publish each improved solution of the ARAPlanner.
+  bool ivAnytimeStreaming;
+  /// The time (in s) after which the search is checked for a new solution.
+  double ivAnytimeStreamingInterval;
+  boost::function<void (const anytime_solution&)> ivSolutionCallback;
+  ros::WallTime ivPlanningStartTime;
+
   std::string ivPlannerType;
   std::string ivMarkerNamespace;
 
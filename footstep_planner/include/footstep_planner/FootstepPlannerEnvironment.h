@@ -21,19 +21,28 @@
 #ifndef FOOTSTEP_PLANNER_FOOTSTEPPLANNERENVIRONMENT_H_
 #define FOOTSTEP_PLANNER_FOOTSTEPPLANNERENVIRONMENT_H_
 
+#include <footstep_planner/CellBitmap.h>
+#include <footstep_planner/ChunkedArena.h>
+#include <footstep_planner/ChunkedVector.h>
+#include <footstep_planner/CollisionCache.h>
+#include <footstep_planner/CollisionLayers.h>
 #include <footstep_planner/helper.h>
 #include <footstep_planner/PathCostHeuristic.h>
 #include <footstep_planner/Heuristic.h>
 #include <footstep_planner/Footstep.h>
 #include <footstep_planner/PlanningState.h>
 #include <footstep_planner/State.h>
+#include <footstep_planner/StateHashTable.h>
+#include <footstep_planner/StepCostTable.h>
+#include <footstep_planner/WorkerPool.h>
 #include <humanoid_nav_msgs/ClipFootstep.h>
 #include <sbpl/headers.h>
 
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include <math.h>
 #include <vector>
-#include <tr1/unordered_set>
-#include <tr1/hashtable.h>
 
 
 namespace footstep_planner
@@ -61,6 +70,40 @@ struct environment_params
   int    num_random_nodes;
   double random_node_distance;
   double heuristic_scale;
+  /// Whether to use precomputed collision layers (see CollisionLayers).
+  bool   collision_layers;
+  /**
+   * Number of threads building all collision layers on a map update (0:
+   * layers are built lazily on first access).
+   */
+  int    collision_layers_threads;
+  /// Memory limit of the collision layers (in MB).
+  int    collision_layers_max_memory;
+  /// Whether to memoize the collision checks (see CollisionCache).
+  bool   collision_cache;
+  /**
+   * Whether to check the collision of a state only when it is expanded
+   * instead of when it is generated as a neighbor.
+   */
+  bool   lazy_collision_check;
+  /**
+   * Number of threads checking the neighbors of a state for collisions
+   * (0, 1: the calling thread only).
+   */
+  int    collision_threads;
+  /// Distance between the two feet of the robot's pose.
+  double foot_separation;
+  /**
+   * File of the precomputed StepCostTable used as heuristic near the goal
+   * (empty: no table).
+   */
+  std::string step_cost_table;
+  /**
+   * The largest factor the planner inflates the heuristic with (e.g. the
+   * initial epsilon of ARA*), the heuristic values are clamped so that the
+   * inflated values do not overflow.
+   */
+  double max_epsilon;
 };
 
 
@@ -74,19 +117,8 @@ struct environment_params
 class FootstepPlannerEnvironment : public DiscreteSpaceInformation
 {
 public:
-  // specialization of hash<int,int>, similar to standard boost::hash on pairs?
-  struct IntPairHash{
-  public:
-    size_t operator()(std::pair<int, int> x) const throw() {
-      size_t seed = std::tr1::hash<int>()(x.first);
-      return std::tr1::hash<int>()(x.second) + 0x9e3779b9 + (seed<<6) + (seed>>2);
-    }
-  };
-
   typedef std::vector<int> exp_states_t;
   typedef exp_states_t::const_iterator exp_states_iter_t;
-  typedef std::tr1::unordered_set<std::pair<int,int>, IntPairHash > exp_states_2d_t;
-  typedef exp_states_2d_t::const_iterator exp_states_2d_iter_t;
 
   /**
    * @param footstep_set The set of footsteps used for the path planning.
@@ -113,8 +145,8 @@ public:
    * @param collision_check_accuracy Whether to check just the foot's
    * circumcircle (0), the incircle (1) or recursively the circumcircle
    * and the incircle for the whole foot (2) for collision.
-   * @param hash_table_size Size of the hash table storing the planning
-   * states expanded during the search.
+   * @param hash_table_size Initial size of the hash table storing the
+   * planning states expanded during the search (grows automatically).
    * @param cell_size The size of each grid cell used to discretize the
    * robot positions.
    * @param num_angle_bins The number of bins used to discretize the
@@ -126,6 +158,14 @@ public:
 
   virtual ~FootstepPlannerEnvironment();
 
+  /**
+   * @return A new environment specialized for the type of params.heuristic
+   * (see FootstepPlannerEnvironmentT) or, for other heuristics, a
+   * FootstepPlannerEnvironment.
+   */
+  static FootstepPlannerEnvironment* create(
+      const environment_params& params);
+
   /**
    * @brief Update the robot's feet poses in the goal state.
    * @return The new IDs (left, right) of the planning state representing the
@@ -163,19 +203,112 @@ public:
    */
   void reset();
 
+  /**
+   * @brief Resets the information of the previous search (i.e. the SBPL
+   * index rows and the expanded states) but keeps all planning states
+   * created so far, as well as the start and goal poses. A new SBPL planner
+   * can then reuse the discovered states (and their cached collision
+   * checks).
+   */
+  void resetSearch();
+
+  /**
+   * @return The memory (in bytes) used by the planning states created since
+   * the last reset(). The storage reserved by previous planning tasks and
+   * kept for reuse is not included.
+   */
+  size_t getMemoryUsage() const;
+
   /// @return The number of expanded states during the search.
   int getNumExpandedStates() { return ivNumExpandedStates; };
 
-  exp_states_2d_iter_t getExpandedStatesStart()
+  /// @return The arena holding all planning states created so far.
+  const ChunkedArena<PlanningState>& getStateArena() const
+  {
+    return ivStateArena;
+  };
+
+  /// @return The arena holding the SBPL index rows (StateID2IndexMapping).
+  const ChunkedArena<int>& getIndexArena() const
+  {
+    return ivIndexArena;
+  };
+
+  /// @return The collision check cache (NULL if not used).
+  boost::shared_ptr<const CollisionCache> getCollisionCache() const
+  {
+    return ivCollisionCachePtr;
+  };
+
+  /// @return The hash table mapping planning states to their IDs.
+  const StateHashTable& getStateHashTable() const
+  {
+    return ivStateHashTable;
+  };
+
+  /**
+   * @brief Enables or disables keeping track of the (x, y) cells of the
+   * expanded states (only needed for visualization).
+   */
+  void setTrackExpandedStates(bool track) { ivTrackExpandedStates = track; };
+
+  /**
+   * @brief Appends the (x, y) cells of all states expanded since the last
+   * reset() (if tracked, see setTrackExpandedStates()).
+   */
+  void getExpandedStates(std::vector<std::pair<int, int> >* cells) const
+  {
+    ivExpandedStates.getCells(cells);
+  };
+
+  /**
+   * @brief Restricts the search to the planning cells whose center lies
+   * within 'width' (in m) of the polyline 'path' (in world coordinates).
+   * Successors and predecessors outside of this corridor are skipped.
+   *
+   * NOTE: Changing the corridor invalidates a previous search, i.e. the
+   * planner has to be reset afterwards. Needs a map (see updateMap()).
+   */
+  void setCorridor(const std::vector<std::pair<double, double> >& path,
+                   double width);
+
+  /// @brief Removes the restriction of setCorridor().
+  void clearCorridor() { ivUseCorridor = false; };
+
+  /// @return True iff the search is restricted to a corridor.
+  bool hasCorridor() const { return ivUseCorridor; };
+
+  /**
+   * @brief Allows GetSuccs(), GetPreds(), the heuristic functions and
+   * getState() to be called concurrently (see PASEPlanner). The collision
+   * checks then run in parallel while the creation of new planning states
+   * is serialized; the lookup of a planning state by its ID is lock-free.
+   *
+   * NOTE: All other methods must not be called during a concurrent search.
+   */
+  void setConcurrentExpansions(bool concurrent)
   {
-    return ivExpandedStates.begin();
+    ivConcurrentExpansions = concurrent;
   };
 
-  exp_states_2d_iter_t getExpandedStatesEnd()
+  /// @return The distance between the two feet of the robot's pose (in m).
+  double getFootSeparation() const
   {
-    return ivExpandedStates.end();
+    return cont_val(ivFootSeparation, ivCellSize);
   };
 
+  /// @return The maximal translation of a footstep (in m).
+  double getMaxStepWidth() const { return ivMaxStepWidth * ivCellSize; };
+
+  bool isForwardSearch() const { return ivForwardSearch; };
+
+  /**
+   * @return True iff GetFromToHeuristic() estimates the costs between any
+   * two states. The PathCostHeuristic only estimates the costs to the goal
+   * (forward planning) or to the start (backward planning).
+   */
+  bool heuristicToAnyState() const { return !ivPathCostHeuristicPtr; };
+
   exp_states_iter_t getRandomStatesStart()
   {
     return ivRandomStates.begin();
@@ -267,11 +400,57 @@ public:
    */
   bool reachable(const PlanningState& from, const PlanningState& to);
 
-  void getPredsOfGridCells(const std::vector<State>& changed_states,
-                           std::vector<int>* pred_ids);
+  /**
+   * @return The costs of the footstep from within planning state
+   * FromStateID to ToStateID or -1 if ToStateID cannot be reached by a
+   * single footstep (see reachable()). (Used to connect the two searches of
+   * the BidirectionalPlanner.)
+   */
+  int getStepCost(int FromStateID, int ToStateID);
+
+  /**
+   * @return A lower bound of the costs of any footstep path from the
+   * position (from_x, from_y) to (to_x, to_y) (in m). Cheaper than the
+   * heuristic and valid in both directions, it is used by the planners to
+   * bound the costs between two arbitrary states.
+   */
+  int getStepCostLowerBound(double from_x, double from_y, double to_x,
+                            double to_y) const;
+
+  /**
+   * @brief Computes lower bounds of the costs of the footstep paths in free
+   * space from all planning states within 'radius' (in m) around the goal
+   * to the goal (for forward planning), one search per goal orientation.
+   * The goal's left foot is placed at the origin and its right foot
+   * 'foot_separation' beside (see computeStepCosts()).
+   *
+   * The costs are exact for the footstep lattice but capped by the
+   * minimal costs of reaching the border of the table (in a straight
+   * line), so the table is a consistent heuristic: a footstep lowers the
+   * cap by at most its costs, also across the border where the table ends.
+   * The search covers twice the radius, so the cap also bounds the costs
+   * of paths leaving the searched area.
+   */
+  void computeStepCostTable(double radius, StepCostTable* table);
+
+  /**
+   * @brief Collects the IDs of all existing planning states placed on one
+   * of the changed (planning grid) cells and of their predecessors, i.e.
+   * the states whose outgoing transitions may have changed. (Used for
+   * replanning with backward search.)
+   */
+  void getPredsOfGridCells(
+      const std::vector<std::pair<int, int> >& changed_cells,
+      std::vector<int>* pred_ids);
 
-  void getSuccsOfGridCells(const std::vector<State>& changed_states,
-                           std::vector<int>* succ_ids);
+  /**
+   * @brief Collects the IDs of all existing planning states placed on one
+   * of the changed (planning grid) cells and of their successors. (Used
+   * for replanning with forward search.)
+   */
+  void getSuccsOfGridCells(
+      const std::vector<std::pair<int, int> >& changed_cells,
+      std::vector<int>* succ_ids);
 
   /**
    * @brief Update the heuristic values (e.g. after the map has changed).
@@ -283,12 +462,92 @@ public:
   /// Used to scale continuous values in meter to discrete values in mm.
   static const int cvMmScale = 1000;
 
+  /// Number of planning states (and SBPL index rows) per arena chunk.
+  static const int cvArenaChunkSize = 4096;
+
+  /// Number of fractional bits of the fixed point rotation tables.
+  static const int cvRotationFixedBits = 16;
+
 protected:
   /**
    * @return The costs (in mm, truncated as int) to reach the
    * planning state ToStateID from within planning state FromStateID.
    */
-  int GetFromToHeuristic(const PlanningState& from, const PlanningState& to);
+  virtual int GetFromToHeuristic(const PlanningState& from,
+                                 const PlanningState& to);
+
+  /**
+   * @brief The heuristic and expansion core shared by all variants of the
+   * environment: for a concrete HeuristicT (see FootstepPlannerEnvironmentT)
+   * the heuristic's inline methods are called without virtual dispatch, for
+   * Heuristic itself getHValue() is called virtually.
+   */
+  template <class HeuristicT>
+  int getFromToHeuristic(const HeuristicT& heuristic,
+                         const PlanningState& from, const PlanningState& to);
+
+  /// @brief GetFromToHeuristic(int, int) for the heuristic type HeuristicT.
+  template <class HeuristicT>
+  int getFromToHeuristic(const HeuristicT& heuristic, int FromStateID,
+                         int ToStateID);
+
+  /// @brief GetGoalHeuristic() for the heuristic type HeuristicT.
+  template <class HeuristicT>
+  int getGoalHeuristic(const HeuristicT& heuristic, int stateID);
+
+  /**
+   * @brief getNeighbors() for the heuristic type HeuristicT: additionally
+   * prefetches the heuristic's data of the new neighbors (which are
+   * evaluated next by the planner).
+   */
+  template <class HeuristicT>
+  void getNeighbors(const HeuristicT& heuristic,
+                    const PlanningState& current,
+                    const std::vector<uint64_t>& key_delta,
+                    const std::vector<int>& step_cost,
+                    std::vector<int>* NeighIDV, std::vector<int>* CostV);
+
+  /// @return The heuristic value (in meter) of HeuristicT (non-virtual).
+  template <class HeuristicT>
+  static double getHValue(const HeuristicT& heuristic,
+                          const PlanningState& from, const PlanningState& to)
+  {
+    return heuristic.HeuristicT::getHValue(from, to);
+  };
+
+  /**
+   * @return The costs (in mm) to reach 'goal' from within 'from' in free
+   * space as stored in the step cost table or -1 if 'from' is not covered
+   * by the table.
+   */
+  int getStepCostTableHeuristic(const PlanningState& from,
+                                const PlanningState& goal) const;
+
+  /**
+   * @brief Dijkstra search backwards from the goal with orientation
+   * 'goal_theta' (left foot at the origin) over the footstep lattice within
+   * 'search_radius' (in cells).
+   *
+   * @param costs The costs (in mm) of all states of the searched area, see
+   * stepCostIndex().
+   */
+  void computeStepCosts(int goal_theta, int search_radius,
+                        std::vector<int>* costs);
+
+  /// @return The index of 's' in the costs of computeStepCosts().
+  size_t stepCostIndex(const PlanningState& s, int search_radius) const
+  {
+    size_t width = 2 * search_radius + 1;
+    return ((size_t(s.getLeg()) * ivNumAngleBins + s.getTheta()) * width +
+            s.getX() + search_radius) * width + s.getY() + search_radius;
+  };
+
+  /**
+   * @return A hash of the footstep lattice (footstep set, step range and
+   * discretization) identifying the configurations a StepCostTable can be
+   * used with.
+   */
+  uint64_t getLatticeSignature() const;
 
   /// @return The step cost for reaching 'b' from within 'a'.
   int  stepCost(const PlanningState& a, const PlanningState& b);
@@ -305,13 +564,23 @@ protected:
 
   void setStateArea(const PlanningState& left, const PlanningState& right);
 
+  /**
+   * @return The index of the first entry belonging to the orientation and
+   * leg of 's' in FootstepPlannerEnvironment::ivStateAreaKeyDelta.
+   */
+  size_t stateAreaRow(const PlanningState& s) const
+  {
+    return (size_t(s.getTheta()) * 2 + (s.getLeg() == LEFT ? 1 : 0)) *
+           ivNumStateAreaSteps;
+  };
+
   /// Wrapper for FootstepPlannerEnvironment::createNewHashEntry(PlanningState).
   const PlanningState* createNewHashEntry(const State& s);
 
   /**
    * @brief Creates a new planning state for 's' and inserts it into the
-   * maps (PlanningState::ivStateId2State,
-   * PlanningState::ivpStateHash2State)
+   * maps (FootstepPlannerEnvironment::ivStateId2State,
+   * FootstepPlannerEnvironment::ivStateHashTable)
    *
    * @return A pointer to the newly created PlanningState.
    */
@@ -322,12 +591,81 @@ protected:
 
   /**
    * @return The pointer to the planning state 's' stored in
-   * FootstepPlannerEnvironment::ivpStateHash2State.
+   * FootstepPlannerEnvironment::ivStateHashTable (NULL if 's' has not
+   * been created yet).
    */
   const PlanningState* getHashEntry(const PlanningState& s);
 
   const PlanningState* createHashEntryIfNotExists(const PlanningState& s);
 
+  /**
+   * @brief Checks the planning states with the given keys for collisions
+   * (in parallel if a collision check pool is used).
+   *
+   * @param collisions Set to 1 for each colliding state, 0 otherwise.
+   */
+  void checkCollisions(const uint64_t* keys, size_t num_keys,
+                       unsigned char* collisions);
+
+  /// @brief Checks the i-th state for checkCollisions().
+  void checkCollision(const uint64_t* keys, unsigned char* collisions,
+                      size_t i);
+
+  /// @return True iff occupied() may be called concurrently.
+  bool concurrentCollisionChecks() const
+  {
+    return ivConcurrentExpansions || ivCollisionCheckPoolPtr;
+  };
+
+  /**
+   * @brief Adds s to the expanded states (thread-safe for concurrent
+   * expansions).
+   */
+  void markExpanded(const PlanningState& s);
+
+  /**
+   * @brief Generates all successors (or predecessors) of 'current' that are
+   * not colliding in one batch: the candidate keys are computed in a
+   * single pass, collision checked and afterwards looked up in (or
+   * inserted into) the hash table.
+   *
+   * @param key_delta Either FootstepPlannerEnvironment::ivSuccessorKeyDelta
+   * or FootstepPlannerEnvironment::ivPredecessorKeyDelta.
+   * @param step_cost The step costs belonging to 'key_delta'.
+   */
+  virtual void getNeighbors(const PlanningState& current,
+                            const std::vector<uint64_t>& key_delta,
+                            const std::vector<int>& step_cost,
+                            std::vector<int>* NeighIDV,
+                            std::vector<int>* CostV);
+
+  /**
+   * @brief Implementation of getPredsOfGridCells()/getSuccsOfGridCells():
+   * a single pass over all existing states, independent of the number of
+   * angle bins.
+   *
+   * @param key_delta The footsteps leading from a collected state to a
+   * state on a changed cell, i.e.
+   * FootstepPlannerEnvironment::ivSuccessorKeyDelta for the predecessors
+   * and FootstepPlannerEnvironment::ivPredecessorKeyDelta for the
+   * successors.
+   */
+  void getStatesOfGridCells(
+      const std::vector<std::pair<int, int> >& changed_cells,
+      const std::vector<uint64_t>& key_delta,
+      std::vector<int>* state_ids);
+
+  /**
+   * @return The index of the first entry belonging to the orientation and
+   * leg of 's' in the neighbor tables (e.g.
+   * FootstepPlannerEnvironment::ivSuccessorKeyDelta).
+   */
+  size_t neighborRow(const PlanningState& s) const
+  {
+    return (size_t(s.getTheta()) * 2 + (s.getLeg() == LEFT ? 1 : 0)) *
+           ivFootstepSet.size();
+  };
+
   /**
    * @return True iff 'goal' can be reached by an arbitrary footstep.
    * (Used for forward planning.)
@@ -364,24 +702,67 @@ protected:
 
   std::vector<int> ivStateArea;
 
+  /// The number of discrete steps within the executable step range.
+  size_t ivNumStateAreaSteps;
+  /**
+   * @brief The changes of the packed state key for each discrete step
+   * within the executable step range (one row of ivNumStateAreaSteps
+   * entries per orientation and leg, see stateAreaRow()); 0 if the step is
+   * not reachable.
+   */
+  std::vector<uint64_t> ivStateAreaKeyDelta;
+
   /**
    * @brief Maps from an ID to the corresponding PlanningState. (Used in
    * the SBPL to access a certain PlanningState.)
    */
-  std::vector<const PlanningState*> ivStateId2State;
+  ChunkedVector<const PlanningState*> ivStateId2State;
+
+  /**
+   * @brief Storage of all planning states (freed at once in
+   * FootstepPlannerEnvironment::reset()).
+   */
+  ChunkedArena<PlanningState> ivStateArena;
 
   /**
-   * @brief Maps from a hash tag to a list of corresponding planning
-   * states. (Used in FootstepPlannerEnvironment to identify a certain
-   * PlanningState.)
+   * @brief Storage of the SBPL index rows referenced by
+   * StateID2IndexMapping (NUMOFINDICES_STATEID2IND ints per state).
    */
-  std::vector<const PlanningState*>* ivpStateHash2State;
+  ChunkedArena<int> ivIndexArena;
+
+  /**
+   * @brief Maps from the packed key of a planning state to its ID. (Used in
+   * FootstepPlannerEnvironment to identify a certain PlanningState.)
+   */
+  StateHashTable ivStateHashTable;
 
   /// The set of footsteps used for the path planning.
   const std::vector<Footstep>& ivFootstepSet;
 
+  /**
+   * @brief The changes of the packed state key when performing each
+   * footstep (structure of arrays, one row of ivFootstepSet.size() entries
+   * per orientation and leg, see neighborRow()).
+   */
+  std::vector<uint64_t> ivSuccessorKeyDelta;
+  /// The step costs belonging to ivSuccessorKeyDelta.
+  std::vector<int> ivSuccessorCost;
+  /// The changes of the packed state key when reversing each footstep.
+  std::vector<uint64_t> ivPredecessorKeyDelta;
+  /// The step costs belonging to ivPredecessorKeyDelta.
+  std::vector<int> ivPredecessorCost;
+
+  /// Scratch space for the candidate keys in getNeighbors().
+  std::vector<uint64_t> ivNeighborKeys;
+  /// Scratch space for the candidate costs in getNeighbors().
+  std::vector<int> ivNeighborCosts;
+  /// Scratch space for the collision check results in getNeighbors().
+  std::vector<unsigned char> ivNeighborCollisions;
+
   /// The heuristic function used by the planner.
   const boost::shared_ptr<Heuristic> ivHeuristicConstPtr;
+  /// ivHeuristicConstPtr if it is a PathCostHeuristic (NULL otherwise).
+  boost::shared_ptr<PathCostHeuristic> ivPathCostHeuristicPtr;
 
   /// Size of the foot in x direction.
   const double ivFootsizeX;
@@ -419,10 +800,12 @@ protected:
    * collision.
    */
   const int ivCollisionCheckAccuracy;
+  /// The foot's dimensions as used by collision_check().
+  const collision_shape ivCollisionShape;
 
   /**
-   * @brief Size of the hash table storing the planning states expanded
-   * during the search. (Also referred to by max_hash_size.)
+   * @brief Initial size of the hash table storing the planning states
+   * expanded during the search. (Also referred to by max_hash_size.)
    */
   const int ivHashTableSize;
 
@@ -430,11 +813,21 @@ protected:
   const double ivCellSize;
   /// The number of bins used to discretize the robot orientations.
   const int ivNumAngleBins;
+  /// Cosine of each angle bin.
+  std::vector<double> ivAngleCos;
+  /// Sine of each angle bin.
+  std::vector<double> ivAngleSin;
+  /// Cosine of each angle bin (fixed point, see cvRotationFixedBits).
+  std::vector<int> ivAngleCosFixed;
+  /// Sine of each angle bin (fixed point, see cvRotationFixedBits).
+  std::vector<int> ivAngleSinFixed;
 
   /// Whether to use forward search (1) or backward search (0).
   const bool ivForwardSearch;
 
   double ivMaxStepWidth;
+  /// The squared maximal step width (used by reachable()).
+  const int64_t ivMaxStepWidthSq;
 
   /// number of random neighbors for R*
   const int ivNumRandomNodes;
@@ -446,6 +839,8 @@ protected:
    * factor.
    */
   double ivHeuristicScale;
+  /// Upper bound of the heuristic values (see environment_params::max_epsilon).
+  const double ivMaxHeuristic;
 
   /// Indicates if heuristic has to be updated.
   bool ivHeuristicExpired;
@@ -453,11 +848,104 @@ protected:
   /// Pointer to the map.
   boost::shared_ptr<gridmap_2d::GridMap2D> ivMapPtr;
 
-  exp_states_2d_t ivExpandedStates;
+  /// Precomputed collision layers (NULL if not used).
+  boost::shared_ptr<CollisionLayers> ivCollisionLayersPtr;
+  /// Number of threads used to build the collision layers (0: lazily).
+  const int ivCollisionLayersThreads;
+
+  /// Cached collision check results (NULL if not used).
+  boost::shared_ptr<CollisionCache> ivCollisionCachePtr;
+
+  /**
+   * Whether the collision of a state is checked only when it is expanded
+   * (colliding states are generated as neighbors but are dead ends).
+   */
+  const bool ivLazyCollisionCheck;
+  /**
+   * The planning cells covered by the map (inclusive), lazily checked
+   * neighbors outside of them are dropped.
+   */
+  int ivMapCellMinX, ivMapCellMinY, ivMapCellMaxX, ivMapCellMaxY;
+
+  /// Whether to keep track of the cells of the expanded states.
+  bool ivTrackExpandedStates;
+  /// The (x, y) cells of the expanded states (if tracked).
+  CellBitmap ivExpandedStates;
+  /// Whether the search is restricted to the cells of ivCorridor.
+  bool ivUseCorridor;
+  /// The (x, y) cells the search is restricted to (see setCorridor()).
+  CellBitmap ivCorridor;
+  /// The changed cells of a map update (see getStatesOfGridCells()).
+  CellBitmap ivChangedCells;
   exp_states_t ivRandomStates;  ///< random intermediate states for R*
   size_t ivNumExpandedStates;
 
+  /// Whether GetSuccs() / GetPreds() may be called concurrently.
+  bool ivConcurrentExpansions;
+  /**
+   * Serializes the changes of the state registry (hash table, state IDs)
+   * and of the expanded states for concurrent expansions.
+   */
+  boost::mutex ivStateRegistryMutex;
+  /// Serializes the access to the collision cache for concurrent checks.
+  boost::mutex ivCollisionCacheMutex;
+  /// Threads checking the neighbors for collisions (NULL if not used).
+  boost::shared_ptr<WorkerPool> ivCollisionCheckPoolPtr;
+
   bool* ivpStepRange;
+
+  /// Distance between the two feet of the robot's pose (in cells).
+  const int ivFootSeparation;
+  /// Costs of the footstep lattice near the goal (NULL if not used).
+  boost::shared_ptr<StepCostTable> ivStepCostTablePtr;
+};
+
+
+/// @brief Heuristics of unknown type are evaluated virtually.
+template <>
+inline double
+FootstepPlannerEnvironment::getHValue<Heuristic>(const Heuristic& heuristic,
+                                                 const PlanningState& from,
+                                                 const PlanningState& to)
+{
+  return heuristic.getHValue(from, to);
+}
+
+
+/**
+ * @brief A FootstepPlannerEnvironment for a heuristic of the exact type
+ * HeuristicT, i.e. the heuristic is inlined into the evaluations of
+ * GetGoalHeuristic() / GetStartHeuristic(). GetSuccs() / GetPreds() reach
+ * the variant through the virtual getNeighbors(), which prefetches the
+ * heuristic's data of the new neighbors.
+ *
+ * Instantiated for EuclideanHeuristic, EuclStepCostHeuristic and
+ * PathCostHeuristic; FootstepPlannerEnvironment::create() selects the
+ * variant matching the configured heuristic.
+ */
+template <class HeuristicT>
+class FootstepPlannerEnvironmentT : public FootstepPlannerEnvironment
+{
+public:
+  /// @param params params.heuristic has to be of the exact type HeuristicT.
+  FootstepPlannerEnvironmentT(const environment_params& params);
+  virtual ~FootstepPlannerEnvironmentT();
+
+  int GetFromToHeuristic(int FromStateID, int ToStateID);
+  int GetGoalHeuristic(int stateID);
+  int GetStartHeuristic(int stateID);
+
+protected:
+  int GetFromToHeuristic(const PlanningState& from, const PlanningState& to);
+
+  void getNeighbors(const PlanningState& current,
+                    const std::vector<uint64_t>& key_delta,
+                    const std::vector<int>& step_cost,
+                    std::vector<int>* NeighIDV, std::vector<int>* CostV);
+
+private:
+  /// The heuristic of the environment (ivHeuristicConstPtr).
+  const HeuristicT& ivHeuristic;
 };
 }
 
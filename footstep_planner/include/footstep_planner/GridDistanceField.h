@@ -0,0 +1,115 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_GRIDDISTANCEFIELD_H_
+#define FOOTSTEP_PLANNER_GRIDDISTANCEFIELD_H_
+
+#include <boost/thread/barrier.hpp>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief Multi-threaded computation of the 8-connected 2D path costs (in mm)
+ * from every cell of a grid to a goal cell, a drop-in replacement for the
+ * SBPL2DGridSearch used by the PathCostHeuristic (with the same transition
+ * costs and obstacle handling for binary grids, i.e. free cells with 0).
+ *
+ * The costs are computed by a bucketed wavefront (Dial's algorithm): bucket
+ * k contains the cells with costs in [k * d, (k+1) * d) where d is the cost
+ * of a straight transition. Since no transition is cheaper than d, the
+ * costs of all cells in a bucket are final once the previous buckets are
+ * expanded, so the cells of a bucket are expanded in parallel (updating the
+ * costs with an atomic compare-and-swap). Cells not reachable from the goal
+ * get INFINITECOST.
+ */
+class GridDistanceField
+{
+public:
+  /// @param num_threads The number of threads used by compute().
+  explicit GridDistanceField(int num_threads);
+  ~GridDistanceField();
+
+  /**
+   * @brief Sets the grid, cells with a value >= obstacle_threshold are not
+   * traversable (same as for SBPL2DGridSearch::search()).
+   *
+   * @param grid The grid cells, index: x * height + y.
+   * @param resolution The size of a grid cell (in m).
+   */
+  void updateGrid(const unsigned char* grid, int width, int height,
+                  unsigned char obstacle_threshold, double resolution);
+
+  /// @brief Computes the path costs of all cells to (goal_x, goal_y).
+  void compute(int goal_x, int goal_y);
+
+  /// @return The path costs (in mm) from the cell (x, y) to the goal.
+  int getDistance(int x, int y) const
+  {
+    return ivDistances[index(x, y)];
+  };
+
+  /**
+   * @brief Copies the path costs (in mm) of all cells into 'distances'
+   * (index: x * height + y).
+   */
+  void getDistances(std::vector<int>* distances) const;
+
+private:
+  /// Cells (buffer indices) of a bucket, one list per thread.
+  typedef std::vector<std::vector<int> > bucket_t;
+
+  /// @return The index of the cell (x, y) in the (padded) buffers.
+  int index(int x, int y) const { return (x + 1) * ivStride + y + 1; };
+
+  /// @brief Worker loop of compute().
+  void expandBuckets(int thread, boost::barrier* barrier,
+                     std::vector<bucket_t>* buckets);
+
+  const int ivNumThreads;
+
+  int ivWidth;
+  int ivHeight;
+  /// Row length of the padded buffers (the grid has a border of one cell).
+  int ivStride;
+
+  /// Index offsets and costs (in mm) of the 8 neighbours.
+  int ivNeighborOffset[8];
+  int ivNeighborCost[8];
+  /// Cost range of a bucket (cost of a straight transition).
+  int ivBucketWidth;
+  /**
+   * Number of buckets in use at the same time (the expanded one and those
+   * reachable by a single transition).
+   */
+  int ivNumBuckets;
+
+  /**
+   * Traversable transitions of each cell: bit i is set iff the neighbour i
+   * can be reached (both cells are free; the cells beside a diagonal
+   * transition are not checked).
+   */
+  std::vector<unsigned char> ivTransitions;
+  std::vector<int> ivDistances;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_GRIDDISTANCEFIELD_H_
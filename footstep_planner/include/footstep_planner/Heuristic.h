@@ -43,10 +43,19 @@ public:
    * @return The heuristically determined path costs to get from
    * state 'from' to state 'to' where 'to' is supposed to be the goal of
    * the planning task. (Costs are in meter.)
+   *
+   * NOTE: the implementations are inline so that the environment can call
+   * them without virtual dispatch (see FootstepPlannerEnvironmentT).
    */
   virtual double getHValue(const PlanningState& from,
                            const PlanningState& to) const = 0;
 
+  /**
+   * @brief Starts loading the data needed by getHValue() for state 's'
+   * (called for new neighbors by FootstepPlannerEnvironmentT, non-virtual).
+   */
+  void prefetch(const PlanningState& s) const {};
+
   HeuristicType getHeuristicType() const { return ivHeuristicType; };
 
 protected:
@@ -98,5 +107,50 @@ private:
   /// longest step width
   const double ivMaxStepWidth;
 };
+
+
+inline double
+EuclideanHeuristic::getHValue(const PlanningState& from,
+                              const PlanningState& to)
+const
+{
+  if (from == to)
+    return 0.0;
+
+  // distance in cell size
+  double dist = euclidean_distance(from.getX(), from.getY(),
+                                   to.getX(), to.getY());
+  // return distance in meter
+  return cont_val(dist, ivCellSize);
+}
+
+
+inline double
+EuclStepCostHeuristic::getHValue(const PlanningState& from,
+                                 const PlanningState& to)
+const
+{
+  if (from == to)
+    return 0.0;
+
+  // distance in meter
+  double dist = cont_val(euclidean_distance(
+      from.getX(), from.getY(), to.getX(), to.getY()), ivCellSize);
+  double expected_steps = dist / ivMaxStepWidth;
+  double diff_angle = 0.0;
+  if (ivDiffAngleCost > 0.0)
+  {
+    // get the number of bins between from.theta and to.theta
+    int diff_angle_disc = (
+        ((to.getTheta() - from.getTheta()) % ivNumAngleBins) +
+        ivNumAngleBins) % ivNumAngleBins;
+    // get the rotation independent from the rotation direction
+    diff_angle = std::abs(angles::normalize_angle(
+        angle_cell_2_state(diff_angle_disc, ivNumAngleBins)));
+  }
+
+  return (dist + expected_steps * ivStepCost +
+      diff_angle * ivDiffAngleCost);
+}
 }
 #endif  // FOOTSTEP_PLANNER_HEURISTIC_H_
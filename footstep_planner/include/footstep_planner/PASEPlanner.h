@@ -0,0 +1,164 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FOOTSTEP_PLANNER_PASEPLANNER_H_
+#define FOOTSTEP_PLANNER_PASEPLANNER_H_
+
+#include <footstep_planner/FootstepPlannerEnvironment.h>
+#include <ros/ros.h>
+#include <sbpl/headers.h>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <set>
+#include <utility>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief A weighted A* search expanding several states in parallel (PA*SE,
+ * "Parallel A* for Slow Expansions", Phillips et al., 2014).
+ *
+ * A state s is expanded as soon as no state s' which is currently expanded
+ * or before s in OPEN can improve it, i.e. g(s) - g(s') <= independence_eps
+ * * h(s', s) with h(s', s) a lower bound of the path costs between the two
+ * states. The costs of the solution are then bounded by initial_eps *
+ * independence_eps times the optimal costs (for an admissible heuristic).
+ * The expansions themselves (i.e. the collision checks) run in parallel,
+ * the bookkeeping of the search is serialized.
+ *
+ * The planner always searches until the first solution and does not reuse
+ * previous searches.
+ */
+class PASEPlanner : public SBPLPlanner
+{
+public:
+  /**
+   * @param environment The environment, its concurrent expansions are
+   * enabled by the planner for the environment's lifetime (see
+   * FootstepPlannerEnvironment::setConcurrentExpansions()).
+   * @param forward_search Whether to search from the start to the goal
+   * (true) or backward.
+   * @param num_threads The number of threads expanding states.
+   * @param independence_eps The factor of the lower bound in the
+   * independence check (>= 1).
+   */
+  PASEPlanner(FootstepPlannerEnvironment* environment, bool forward_search,
+              int num_threads, double independence_eps);
+  virtual ~PASEPlanner();
+
+  virtual int replan(double allocated_time_sec,
+                     std::vector<int>* solution_stateIDs_V);
+  virtual int replan(double allocated_time_sec,
+                     std::vector<int>* solution_stateIDs_V, int* solcost);
+  virtual int set_goal(int goal_stateID);
+  virtual int set_start(int start_stateID);
+  virtual int force_planning_from_scratch();
+  virtual int set_search_mode(bool bSearchUntilFirstSolution);
+  virtual void costs_changed(const StateChangeQuery& stateChange);
+
+  virtual double get_solution_eps() const;
+  virtual int get_n_expands() const { return ivNumExpands; };
+  virtual double get_initial_eps() { return ivEps; };
+  virtual double get_final_epsilon() { return get_solution_eps(); };
+  virtual void set_initialsolution_eps(double initialsolution_eps);
+
+private:
+  enum List { NONE = 0, OPEN, BEING_EXPANDED, CLOSED };
+
+  struct SearchState
+  {
+    SearchState()
+    : g(INFINITECOST), h(-1), f(INFINITECOST), parent(-1), x(0), y(0),
+      list(NONE)
+    {};
+
+    int g;
+    int h;
+    int f;
+    /// The state this state has been reached from.
+    int parent;
+    /// The position of the planning state (in m).
+    double x, y;
+    unsigned char list;
+  };
+
+  /// OPEN ordered by (f, state ID).
+  typedef std::set<std::pair<int, int> > open_t;
+
+  /// @brief Expands states until the search is finished (run by each thread).
+  void expandStates();
+
+  /**
+   * @brief Removes the first state from OPEN which is independent of all
+   * states before it in OPEN and all states being expanded.
+   * @return The state's ID or -1 if there is no such state.
+   */
+  int selectState();
+
+  /**
+   * @return True iff the state s cannot be improved by expanding 'other',
+   * i.e. g(s) - g(other) <= independence_eps * h(other, s).
+   */
+  bool independent(const SearchState& s, const SearchState& other) const;
+
+  /**
+   * @return The search information of a state (initialized on first
+   * access). NOTE: invalidates previously returned references.
+   */
+  SearchState& getSearchState(int id);
+
+  FootstepPlannerEnvironment* ivEnvironment;
+  const bool ivForwardSearch;
+  const int ivNumThreads;
+  const double ivIndependenceEps;
+  double ivEps;
+
+  int ivStartId;
+  int ivGoalId;
+
+  /// The number of states before a state in OPEN checked by selectState().
+  const size_t ivMaxSelectionDepth;
+
+  /// The search information of all states (index: state ID).
+  std::vector<SearchState> ivSearchStates;
+  open_t ivOpen;
+  /// The states currently expanded.
+  std::vector<int> ivBeingExpanded;
+  int ivNumExpands;
+
+  /// The state the search terminates at (goal or start).
+  int ivTargetId;
+  bool ivDone;
+  bool ivFound;
+  ros::WallTime ivDeadline;
+
+  /// Serializes the bookkeeping of the search.
+  boost::mutex ivMutex;
+  /// Signals a finished expansion.
+  boost::condition_variable ivExpansionFinished;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_PASEPLANNER_H_
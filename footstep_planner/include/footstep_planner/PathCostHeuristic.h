@@ -21,10 +21,15 @@
 #ifndef FOOTSTEP_PLANNER_PATHCOSTHEURISTIC_H_
 #define FOOTSTEP_PLANNER_PATHCOSTHEURISTIC_H_
 
+#include <footstep_planner/GridDistanceField.h>
 #include <footstep_planner/Heuristic.h>
 #include <gridmap_2d/GridMap2D.h>
 #include <sbpl/headers.h>
 
+#include <list>
+#include <map>
+#include <vector>
+
 
 namespace footstep_planner
 {
@@ -45,9 +50,16 @@ namespace footstep_planner
 class PathCostHeuristic : public Heuristic
 {
 public:
+  /**
+   * @param cache_size The maximal number of distance grids (one per goal
+   * cell) kept in the cache (0: no caching).
+   * @param cache_max_memory The maximal memory (in bytes) used by the
+   * cached distance grids.
+   */
   PathCostHeuristic(double cell_size, int num_angle_bins,
                     double step_cost, double diff_angle_cost,
-                    double max_step_width, double inflation_radius);
+                    double max_step_width, double inflation_radius,
+                    int cache_size=0, size_t cache_max_memory=0);
   virtual ~PathCostHeuristic();
 
   /**
@@ -57,6 +69,16 @@ public:
   virtual double getHValue(const PlanningState& current,
                            const PlanningState& to) const;
 
+  /// @brief Starts loading the 2D path costs of the map cell of 's'.
+  void prefetch(const PlanningState& s) const
+  {
+    if (!ivDistances)
+      return;
+    size_t index = mapIndex(s);
+    if (index != cvOutsideMap)
+      __builtin_prefetch(&ivDistances[index]);
+  };
+
   /**
    * @brief Calculates for each grid cell of the map a 2D path to the
    * cell (to.x, to.y).
@@ -67,10 +89,98 @@ public:
 
   void updateMap(gridmap_2d::GridMap2DPtr map);
 
+  /**
+   * @brief Extracts the 2D path from the map cell containing (x, y) (in world
+   * coordinates) to the cell the distances have been calculated for (see
+   * calculateDistances()) by descending the 2D path costs.
+   *
+   * @param path The centers of the map cells along the path.
+   * @return False if the cell is outside of the map, unreachable or the
+   * descent does not reach the goal cell.
+   */
+  bool getPath(double x, double y,
+               std::vector<std::pair<double, double> >* path) const;
+
+  /**
+   * @brief Computes the 2D path costs with the (multi-threaded)
+   * GridDistanceField instead of the SBPL2DGridSearch. Has to be called
+   * before the first map update.
+   */
+  void useGridDistanceField(int num_threads);
+
+  /**
+   * @return The number of calculateDistances() calls for a new goal cell
+   * answered by the cache.
+   */
+  unsigned int getNumCacheHits() const { return ivNumCacheHits; };
+
+  /**
+   * @return The number of calculateDistances() calls for a new goal cell
+   * that required a 2D search.
+   */
+  unsigned int getNumCacheMisses() const { return ivNumCacheMisses; };
+
 private:
+  /// (map version, (goal x, goal y))
+  typedef std::pair<unsigned int, std::pair<int, int> > distances_key_t;
+  /// 2D path costs (in mm) of all map cells, index: x * height + y
+  typedef boost::shared_ptr<const std::vector<int> > distances_ptr_t;
+  /// Cached distance grids, the most recently used one first.
+  typedef std::list<std::pair<distances_key_t, distances_ptr_t> >
+      distances_cache_t;
+
+  /**
+   * @brief Inserts a distance grid into the cache and evicts the least
+   * recently used ones exceeding the size or memory limit.
+   */
+  void cacheDistances(const distances_key_t& key, distances_ptr_t distances);
+
+  /**
+   * @return The index of the map cell containing the planning state s in
+   * the distance grids (index: x * height + y), cvOutsideMap if s is
+   * outside of the map.
+   */
+  size_t mapIndex(const PlanningState& s) const
+  {
+    // cast to unsigned int also maps cells below the minimum out of range
+    unsigned int x = s.getX() - ivPlanningCellMinX;
+    unsigned int y = s.getY() - ivPlanningCellMinY;
+    if (x < ivMapRowOffsets.size() && y < ivMapCellsY.size())
+      return ivMapRowOffsets[x] + ivMapCellsY[y];
+    return mapIndexNoTable(s);
+  };
+
+  /**
+   * @brief mapIndex() for planning states not covered by the table.
+   * @return cvOutsideMap for planning states outside of the map.
+   */
+  size_t mapIndexNoTable(const PlanningState& s) const;
+
+  /**
+   * @return The 2D path costs (in mm) of the map cell 'index' (see
+   * mapIndex()) to the cell the distances have been calculated for.
+   */
+  int getDistance(size_t index) const
+  {
+    if (ivDistances)
+      return ivDistances[index];
+    unsigned int height = ivMapPtr->getInfo().height;
+    return ivGridSearchPtr->getlowerboundoncostfromstart_inmm(
+        index / height, index % height);
+  };
+
+  /// mapIndex() of planning states outside of the map.
+  static const size_t cvOutsideMap = size_t(-1);
+
   static const int cvObstacleThreshold = 200;
 
-  unsigned char** ivpGrid;
+  /**
+   * Inflated obstacles of the map (255: occupied, 0: free) in one
+   * contiguous buffer, index: x * height + y.
+   */
+  std::vector<unsigned char> ivGrid;
+  /// Pointers to the rows of ivGrid (the grid as used by SBPL2DGridSearch).
+  std::vector<unsigned char*> ivGridRows;
 
   double ivStepCost;
   double ivDiffAngleCost;
@@ -80,10 +190,69 @@ private:
   int ivGoalX;
   int ivGoalY;
 
+  /// The distance grid to the current goal cell.
+  distances_ptr_t ivDistancesPtr;
+  /**
+   * Pointer to the data of ivDistancesPtr (NULL: the distances are read
+   * from the grid search, see getDistance()).
+   */
+  const int* ivDistances;
+
+  /// Factor from 2D path costs (in mm) to distance and expected step costs.
+  double ivDistanceFactor;
+  /// Costs of the orientation difference for each difference of angle bins.
+  std::vector<double> ivAngleDiffCosts;
+
+  /**
+   * The offsets (x * height) and y coordinates of the map cells containing
+   * the planning cells from ivPlanningCellMinX / ivPlanningCellMinY on.
+   */
+  std::vector<size_t> ivMapRowOffsets;
+  std::vector<size_t> ivMapCellsY;
+  int ivPlanningCellMinX;
+  int ivPlanningCellMinY;
+
+  distances_cache_t ivDistancesCache;
+  std::map<distances_key_t, distances_cache_t::iterator> ivDistancesCacheIndex;
+  const int    ivCacheSize;
+  const size_t ivCacheMaxMemory;
+  unsigned int ivNumCacheHits;
+  unsigned int ivNumCacheMisses;
+
+  /// Incremented with each map update (part of the cache key).
+  unsigned int ivMapVersion;
+
   gridmap_2d::GridMap2DPtr ivMapPtr;
   boost::shared_ptr<SBPL2DGridSearch> ivGridSearchPtr;
-
-  void resetGrid();
+  boost::shared_ptr<GridDistanceField> ivDistanceFieldPtr;
 };
+
+
+inline double
+PathCostHeuristic::getHValue(const PlanningState& current,
+                             const PlanningState& to)
+const
+{
+  assert(ivGoalX >= 0 && ivGoalY >= 0);
+  // the distances have to be calculated for 'to' by calculateDistances()
+  assert(mapIndex(to) == size_t(ivGoalX) * ivMapPtr->getInfo().height +
+                         ivGoalY);
+
+  if (current == to)
+    return 0.0;
+
+  // get the number of bins between from.theta and to.theta
+  int diff_angle_disc = (
+      ((to.getTheta() - current.getTheta()) % ivNumAngleBins) +
+      ivNumAngleBins) % ivNumAngleBins;
+
+  // states outside of the map (not yet collision checked in the lazy
+  // mode) are treated like unreachable cells
+  size_t index = mapIndex(current);
+  int distance = index != cvOutsideMap ? getDistance(index) : INFINITECOST;
+
+  return (distance * ivDistanceFactor +
+          ivAngleDiffCosts[diff_angle_disc]);
+}
 }
 #endif  // FOOTSTEP_PLANNER_PATHCOSTHEURISTIC_H_
@@ -39,8 +39,9 @@ namespace footstep_planner
  * resolution of the grid map.)
  *
  * The SBPL can access each planning state via an unique ID. Furthermore
- * each planning state can be identified by an (ununique) hash tag generated
- * from its position, location and supporting leg.
+ * each planning state is identified by a unique 64 bit key packing its
+ * position, orientation and supporting leg (see calc_state_key()), which
+ * is also used for hashing and comparison.
  */
 class PlanningState
 {
@@ -54,37 +55,41 @@ public:
    * position.
    * @param num_angle_bins The number of bins discretizing the
    * orientation.
-   * @param max_hash_size
    */
   PlanningState(double x, double y, double theta, Leg leg,
-                double cell_size, int num_angle_bins, int max_hash_size);
+                double cell_size, int num_angle_bins);
 
   /**
    * @brief x, y and theta as discrete bin values (as used internally by
    * the planner).
    */
-  PlanningState(int x, int y, int theta, Leg leg, int max_hash_size);
+  PlanningState(int x, int y, int theta, Leg leg);
 
   /// Create a (discrete) PlanningState from a (continuous) State.
-  PlanningState(const State& s, double cell_size, int num_angle_bins,
-                int max_hash_size);
+  PlanningState(const State& s, double cell_size, int num_angle_bins);
+
+  /// Create a PlanningState from its packed key.
+  explicit PlanningState(uint64_t key)
+  : ivKey(key),
+    ivId(-1)
+  {};
 
   /// Copy constructor.
   PlanningState(const PlanningState& s);
 
   ~PlanningState();
 
-  /**
-   * @brief Compare two states on equality of x, y, theta, leg. Makes
-   * first use of the non-unique hash tag to rule out unequal states.
-   */
-  bool operator ==(const PlanningState& s2) const;
+  /// @brief Compare two states on equality of x, y, theta, leg.
+  bool operator ==(const PlanningState& s2) const
+  {
+    return ivKey == s2.ivKey;
+  };
 
-  /**
-   * @brief Compare two states on inequality of x, y, theta, leg by
-   * comparing the hash tags of the states.
-   */
-  bool operator !=(const PlanningState& s2) const;
+  /// @brief Compare two states on inequality of x, y, theta, leg.
+  bool operator !=(const PlanningState& s2) const
+  {
+    return ivKey != s2.ivKey;
+  };
 
   /**
    * @brief Used to attach such an unique ID to the planning state. (This
@@ -93,16 +98,19 @@ public:
    */
   void setId(unsigned int id) { ivId = id; };
 
-  Leg getLeg() const { return ivLeg; };
-  int getTheta() const { return ivTheta; };
-  int getX() const { return ivX; };
-  int getY() const { return ivY; };
+  Leg getLeg() const { return Leg(state_key_leg(ivKey)); };
+  int getTheta() const { return state_key_theta(ivKey); };
+  int getX() const { return state_key_x(ivKey); };
+  int getY() const { return state_key_y(ivKey); };
 
   /**
-   * @return The (non-unique) hash tag used to identify the planning
+   * @return The (unique) key packing x, y, theta and leg of the planning
    * state.
    */
-  unsigned int getHashTag() const { return ivHashTag; };
+  uint64_t getKey() const { return ivKey; };
+
+  /// @return The hash value of the planning state's key.
+  uint64_t getHashTag() const { return key_hash(ivKey); };
 
   /**
    * @return The (unique) ID used within the SBPL to access the
@@ -114,23 +122,11 @@ public:
   State getState(double cell_size, int num_angle_bins) const;
 
 private:
-  /// Value of the grid cell the position's x value is fitted into.
-  int ivX;
-  /// Value of the grid cell the position's y value is fitted into.
-  int ivY;
-  /// Number of the bin the orientation is fitted into.
-  int ivTheta;
-  /// The supporting leg.
-  Leg	ivLeg;
+  /// The packed x, y, theta and leg (see calc_state_key()).
+  uint64_t ivKey;
 
   /// The (unique) ID of the planning state.
   int ivId;
-
-  /**
-   * The (non-unique) hash tag of the planning state. Different hash tags
-   * imply that the states differ in x, y, theta, leg.
-   */
-  unsigned int ivHashTag;
 };
 }
 #endif  // FOOTSTEP_PLANNER_PLANNINGSTATE_H_
@@ -0,0 +1,161 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_STATEHASHTABLE_H_
+#define FOOTSTEP_PLANNER_STATEHASHTABLE_H_
+
+#include <footstep_planner/helper.h>
+
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief An open addressing hash table (linear probing) mapping the packed
+ * key of a PlanningState (see calc_state_key()) to its SBPL state ID.
+ *
+ * The keys and IDs are stored inline in one contiguous array, so a lookup
+ * usually touches a single cache line. The table grows automatically when
+ * the load factor exceeds cvMaxLoadFactor. Entries are never removed one
+ * by one, only the whole table can be cleared.
+ */
+class StateHashTable
+{
+public:
+  /**
+   * @param initial_size The initial number of slots (rounded up to the
+   * next power of two).
+   */
+  StateHashTable(unsigned int initial_size);
+  ~StateHashTable();
+
+  /// @return The ID stored for 'key' or -1 if there is no such entry.
+  int find(uint64_t key) const;
+
+  /**
+   * @brief Inserts a new (key, id) pair. The key must not be contained in
+   * the table yet.
+   */
+  void insert(uint64_t key, int id);
+
+  /**
+   * @brief Hints the CPU to load the first slot probed for 'key' into the
+   * cache (used to overlap the memory accesses of several lookups).
+   */
+  void prefetch(uint64_t key) const
+  {
+#ifdef __GNUC__
+    __builtin_prefetch(&ivEntries[key_hash(key) & ivMask]);
+#endif
+  };
+
+  /// @brief Removes all entries (keeps the current capacity).
+  void clear();
+
+  /// @return The number of stored entries.
+  size_t size() const { return ivSize; };
+
+  /// @return The number of slots.
+  size_t capacity() const { return ivEntries.size(); };
+
+  /// @return The memory (in bytes) used by the slots.
+  size_t getMemoryUsage() const { return ivEntries.size() * sizeof(Entry); };
+
+  /// @return The memory (in bytes) of the slots occupied by entries.
+  size_t getUsedMemory() const { return ivSize * sizeof(Entry); };
+
+  /// @return The number of find() calls since the last statistics reset.
+  unsigned long getNumLookups() const { return ivNumLookups; };
+
+  /// @return The average number of slots visited by find().
+  double getAvgProbeLength() const
+  {
+    return ivNumLookups ? double(ivNumProbes) / ivNumLookups : 0.0;
+  };
+
+  /// @return The maximal number of slots visited by a single find().
+  unsigned int getMaxProbeLength() const { return ivMaxProbeLength; };
+
+  /// @return The number of times the table was grown.
+  unsigned int getNumResizes() const { return ivNumResizes; };
+
+  void resetStatistics();
+
+  /// The table grows when this fraction of the slots is occupied.
+  static const double cvMaxLoadFactor;
+
+private:
+  struct Entry
+  {
+    uint64_t key;
+    int      id;  ///< -1 marks an empty slot
+  };
+
+  /// @brief Doubles the number of slots and reinserts all entries.
+  void grow();
+
+  void insertNoGrow(uint64_t key, int id);
+
+  void recordProbes(unsigned int probes) const
+  {
+    ++ivNumLookups;
+    ivNumProbes += probes;
+    if (probes > ivMaxProbeLength)
+      ivMaxProbeLength = probes;
+  }
+
+  std::vector<Entry> ivEntries;
+  /// Number of slots - 1 (the number of slots is a power of two).
+  size_t ivMask;
+  size_t ivSize;
+  /// Number of entries that triggers the next grow().
+  size_t ivGrowThreshold;
+
+  mutable unsigned long ivNumLookups;
+  mutable unsigned long ivNumProbes;
+  mutable unsigned int  ivMaxProbeLength;
+  unsigned int ivNumResizes;
+};
+
+
+inline int
+StateHashTable::find(uint64_t key)
+const
+{
+  size_t i = key_hash(key) & ivMask;
+  unsigned int probes = 1;
+  while (ivEntries[i].id >= 0)
+  {
+    if (ivEntries[i].key == key)
+    {
+      recordProbes(probes);
+      return ivEntries[i].id;
+    }
+    i = (i + 1) & ivMask;
+    ++probes;
+  }
+
+  recordProbes(probes);
+  return -1;
+}
+}
+
+#endif  // FOOTSTEP_PLANNER_STATEHASHTABLE_H_
@@ -0,0 +1,126 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOOTSTEP_PLANNER_STEPCOSTTABLE_H_
+#define FOOTSTEP_PLANNER_STEPCOSTTABLE_H_
+
+#include <footstep_planner/helper.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief Lookup table of the costs (in mm) of the optimal footstep paths in
+ * free space from all planning states within a radius around the goal to
+ * the goal (see FootstepPlannerEnvironment::computeStepCostTable()).
+ *
+ * The states are given relative to the goal (left foot) with one table per
+ * orientation of the goal: the footstep lattice is not invariant to
+ * rotations, i.e. rotating the costs of one goal orientation would not give
+ * a lower bound for the others. The costs of each cell are stored exactly
+ * and are blended to 0 towards the border of the table, so that the table
+ * is a consistent heuristic (see computeStepCostTable()). The table is
+ * computed once (offline) for a footstep set and stored in a binary file.
+ * The signature of the footstep lattice the table was computed for is
+ * stored with it so that a table not matching the current configuration
+ * can be rejected.
+ */
+class StepCostTable
+{
+public:
+  StepCostTable();
+  ~StepCostTable();
+
+  /**
+   * @brief Resizes the table to all relative positions within 'radius'
+   * (in cells) for each goal orientation, all costs are set to be unknown.
+   */
+  void resize(int radius, int num_angle_bins, uint64_t signature);
+
+  /**
+   * @return True iff the table could be read from 'filename' and was
+   * computed for 'num_angle_bins' and the lattice 'signature'. The header
+   * is checked against these values and the file size before the table is
+   * allocated.
+   */
+  bool load(const std::string& filename, int num_angle_bins,
+            uint64_t signature);
+
+  /// @return True iff the table could be written to 'filename'.
+  bool save(const std::string& filename) const;
+
+  /// @return True iff (dx, dy) is covered by the table.
+  bool contains(int dx, int dy) const
+  {
+    return std::abs(dx) <= ivRadius && std::abs(dy) <= ivRadius;
+  };
+
+  /**
+   * @return The costs (in mm) to reach the goal with orientation
+   * 'goal_theta' from the state (goal + (dx, dy), theta, leg) or -1 if
+   * they are unknown (or the state is not covered by the table).
+   */
+  int lookup(int goal_theta, int dx, int dy, int theta, Leg leg) const
+  {
+    if (!contains(dx, dy))
+      return -1;
+    uint16_t cost = ivCosts[index(goal_theta, dx, dy, theta, leg)];
+    return cost == cvUnknown ? -1 : cost;
+  };
+
+  /// @brief Sets the costs (saturated to cvUnknown - 1) of a relative state.
+  void set(int goal_theta, int dx, int dy, int theta, Leg leg, int cost)
+  {
+    ivCosts[index(goal_theta, dx, dy, theta, leg)] =
+        uint16_t(std::min(cost, int(cvUnknown) - 1));
+  };
+
+  int getRadius() const { return ivRadius; };
+  int getNumAngleBins() const { return ivNumAngleBins; };
+  uint64_t getSignature() const { return ivSignature; };
+
+  /// Marks unknown costs.
+  static const uint16_t cvUnknown = 0xFFFF;
+
+private:
+  size_t index(int goal_theta, int dx, int dy, int theta, Leg leg) const
+  {
+    size_t width = 2 * ivRadius + 1;
+    return (((size_t(goal_theta) * 2 + size_t(leg == LEFT)) *
+             ivNumAngleBins + theta) * width +
+            (dx + ivRadius)) * width + (dy + ivRadius);
+  };
+
+  /// @return The number of costs of a table with the given dimensions.
+  static size_t numCosts(int radius, int num_angle_bins);
+
+  int ivRadius;
+  int ivNumAngleBins;
+  uint64_t ivSignature;
+
+  std::vector<uint16_t> ivCosts;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_STEPCOSTTABLE_H_
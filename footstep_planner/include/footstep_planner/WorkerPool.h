@@ -0,0 +1,88 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FOOTSTEP_PLANNER_WORKERPOOL_H_
+#define FOOTSTEP_PLANNER_WORKERPOOL_H_
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <stddef.h>
+
+
+namespace footstep_planner
+{
+/**
+ * @brief A fixed set of threads (started once) processing batches of
+ * independent tasks. The thread calling run() takes part in processing
+ * the batch.
+ */
+class WorkerPool
+{
+public:
+  /// @param num_threads The number of threads including the calling one.
+  explicit WorkerPool(int num_threads);
+  ~WorkerPool();
+
+  /**
+   * @brief Calls task(i) for all i in [0, num_tasks) in parallel and
+   * returns once all calls are finished. Must not be called concurrently.
+   */
+  void run(size_t num_tasks, const boost::function<void (size_t)>& task);
+
+  /// @return The number of threads including the calling one.
+  int getNumThreads() const { return ivNumThreads; };
+
+private:
+  /// Copying is not supported.
+  WorkerPool(const WorkerPool&);
+  WorkerPool& operator=(const WorkerPool&);
+
+  /// @brief Main loop of the worker threads.
+  void work();
+
+  /// @brief Processes tasks of the current batch until none is left.
+  void processBatch();
+
+  const int ivNumThreads;
+  boost::thread_group ivThreads;
+
+  boost::mutex ivMutex;
+  /// Signals a new batch (or the shutdown) to the workers.
+  boost::condition_variable ivBatchStarted;
+  /// Signals that no worker is processing a batch any more.
+  boost::condition_variable ivWorkersIdle;
+
+  const boost::function<void (size_t)>* ivTask;
+  size_t ivNumTasks;
+  /// The next task to be processed (incremented atomically).
+  size_t ivNextTask;
+  /// Incremented with each batch.
+  unsigned int ivBatch;
+  /// The number of workers processing the current batch.
+  int ivNumActive;
+  bool ivStop;
+};
+}
+
+#endif  // FOOTSTEP_PLANNER_WORKERPOOL_H_
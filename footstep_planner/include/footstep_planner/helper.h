@@ -30,6 +30,7 @@
 #include <tf/tf.h>
 
 #include <math.h>
+#include <stdint.h>
 
 
 namespace footstep_planner
@@ -144,31 +145,100 @@ inline double cont_val(int length, double cell_size)
 }
 
 
-/// @return The hash value of the key.
-inline unsigned int int_hash(int key)
+/// Number of bits used for each of the x and y cells in a packed state key.
+static const int STATE_KEY_XY_BITS = 24;
+/// Number of bits used for the angle bin in a packed state key.
+static const int STATE_KEY_THETA_BITS = 14;
+/// Number of bits used for the leg in a packed state key.
+static const int STATE_KEY_LEG_BITS = 2;
+/// Bit position of the x cell in a packed state key.
+static const int STATE_KEY_X_SHIFT =
+    STATE_KEY_XY_BITS + STATE_KEY_THETA_BITS + STATE_KEY_LEG_BITS;
+/// Bit position of the y cell in a packed state key.
+static const int STATE_KEY_Y_SHIFT = STATE_KEY_THETA_BITS + STATE_KEY_LEG_BITS;
+/// Bit position of the angle bin in a packed state key.
+static const int STATE_KEY_THETA_SHIFT = STATE_KEY_LEG_BITS;
+
+
+/**
+ * @return A unique 64 bit key for a PlanningState (represented by x, y,
+ * theta and leg). The layout is [x:24][y:24][theta:14][leg:2], x and y
+ * are stored with an offset so that negative cells can be represented.
+ */
+inline uint64_t calc_state_key(int x, int y, int theta, int leg)
 {
-  key += (key << 12);
-  key ^= (key >> 22);
-  key += (key << 4);
-  key ^= (key >> 9);
-  key += (key << 10);
-  key ^= (key >> 2);
-  key += (key << 7);
-  key ^= (key >> 12);
-  return key;
+  const int64_t xy_offset = int64_t(1) << (STATE_KEY_XY_BITS - 1);
+  const uint64_t xy_mask = (uint64_t(1) << STATE_KEY_XY_BITS) - 1;
+  const uint64_t theta_mask = (uint64_t(1) << STATE_KEY_THETA_BITS) - 1;
+  const uint64_t leg_mask = (uint64_t(1) << STATE_KEY_LEG_BITS) - 1;
+
+  return ((uint64_t(x + xy_offset) & xy_mask) << STATE_KEY_X_SHIFT) |
+         ((uint64_t(y + xy_offset) & xy_mask) << STATE_KEY_Y_SHIFT) |
+         ((uint64_t(theta) & theta_mask) << STATE_KEY_THETA_SHIFT) |
+         (uint64_t(leg) & leg_mask);
+}
+
+
+/// @return The x cell stored in a packed state key.
+inline int state_key_x(uint64_t key)
+{
+  return int((key >> STATE_KEY_X_SHIFT) &
+             ((uint64_t(1) << STATE_KEY_XY_BITS) - 1)) -
+         (1 << (STATE_KEY_XY_BITS - 1));
+}
+
+
+/// @return The y cell stored in a packed state key.
+inline int state_key_y(uint64_t key)
+{
+  return int((key >> STATE_KEY_Y_SHIFT) &
+             ((uint64_t(1) << STATE_KEY_XY_BITS) - 1)) -
+         (1 << (STATE_KEY_XY_BITS - 1));
+}
+
+
+/// @return The angle bin stored in a packed state key.
+inline int state_key_theta(uint64_t key)
+{
+  return int((key >> STATE_KEY_THETA_SHIFT) &
+             ((uint64_t(1) << STATE_KEY_THETA_BITS) - 1));
+}
+
+
+/// @return The leg stored in a packed state key.
+inline int state_key_leg(uint64_t key)
+{
+  return int(key & ((uint64_t(1) << STATE_KEY_LEG_BITS) - 1));
+}
+
+
+/**
+ * @return The value that has to be added to a packed state key to change
+ * its x, y, theta and leg by the given (signed) amounts. (This is valid as
+ * long as none of the resulting fields leaves its range, the additions are
+ * done modulo 2^64.)
+ */
+inline uint64_t calc_state_key_delta(int dx, int dy, int dtheta, int dleg)
+{
+  return (uint64_t(int64_t(dx)) << STATE_KEY_X_SHIFT) +
+         (uint64_t(int64_t(dy)) << STATE_KEY_Y_SHIFT) +
+         (uint64_t(int64_t(dtheta)) << STATE_KEY_THETA_SHIFT) +
+         uint64_t(int64_t(dleg));
 }
 
 
 /**
- * @return The hash tag for a PlanningState (represented by x, y, theta and
- * leg).
+ * @return The hash value of a 64 bit key (finalizer of MurmurHash3, mixes
+ * all input bits into the lower bits).
  */
-inline unsigned int calc_hash_tag(int x, int y, int theta, int leg,
-                                  int max_hash_size)
+inline uint64_t key_hash(uint64_t key)
 {
-  return int_hash((int_hash(x) << 3) + (int_hash(y) << 2) +
-                  (int_hash(theta) << 1) + (int_hash(leg)))
-      % max_hash_size;
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
 }
 
 
@@ -202,6 +272,48 @@ bool collision_check(double x, double y, double theta,
                      const gridmap_2d::GridMap2D& distance_map);
 
 
+/**
+ * @brief Quantities of a foot (rectangle) needed by collision_check() that
+ * only depend on its dimensions, i.e. can be computed once per planner.
+ */
+struct collision_shape
+{
+  /**
+   * @param height Size of the foot in x direction.
+   * @param width Size of the foot in y direction.
+   * @param accuracy See collision_check().
+   */
+  collision_shape(double height, double width, int accuracy);
+
+  double height;
+  double width;
+  /// Radius of the circumcircle.
+  double r_o;
+  int accuracy;
+};
+
+
+/**
+ * @brief Same as the above collision_check() but with the foot's rotation
+ * given by its (precomputed) cosine and sine. Instead of recursing, the
+ * sub-rectangles still to be checked are kept on a fixed size stack, both
+ * halves of a split share their circumcircle radius.
+ *
+ * @param x Global position of the foot in x direction.
+ * @param y Global position of the foot in y direction.
+ * @param theta_cos Cosine of the foot's global orientation.
+ * @param theta_sin Sine of the foot's global orientation.
+ * @param shape The (precomputed) dimensions of the foot.
+ * @param distance_map Contains distance information to the nearest
+ * obstacle.
+ *
+ * @return True if the footstep collides with an obstacle.
+ */
+bool collision_check(double x, double y, double theta_cos, double theta_sin,
+                     const collision_shape& shape,
+                     const gridmap_2d::GridMap2D& distance_map);
+
+
 /**
  * @brief Crossing number method to determine whether a point lies within a
  * polygon or not.
@@ -0,0 +1,332 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/BidirectionalPlanner.h>
+
+#include <algorithm>
+#include <math.h>
+
+
+namespace footstep_planner
+{
+BidirectionalPlanner::BidirectionalPlanner(
+    FootstepPlannerEnvironment* environment)
+: ivEnvironment(environment),
+  ivEps(1.0),
+  ivStartId(-1),
+  ivGoalId(-1),
+  ivBucketSize(1.0),
+  ivNumExpands(0),
+  ivSolutionCost(INFINITECOST),
+  ivSolutionForwardId(-1),
+  ivSolutionBackwardId(-1)
+{}
+
+
+BidirectionalPlanner::~BidirectionalPlanner()
+{}
+
+
+int
+BidirectionalPlanner::replan(double allocated_time_sec,
+                             std::vector<int>* solution_stateIDs_V)
+{
+  int solcost;
+  return replan(allocated_time_sec, solution_stateIDs_V, &solcost);
+}
+
+
+int
+BidirectionalPlanner::replan(double allocated_time_sec,
+                             std::vector<int>* solution_stateIDs_V,
+                             int* solcost)
+{
+  solution_stateIDs_V->clear();
+  if (ivStartId < 0 || ivGoalId < 0)
+    return 0;
+
+  // all states reachable by a footstep lie within the neighboring buckets
+  ivBucketSize = ivEnvironment->getMaxStepWidth();
+
+  ivNumExpands = 0;
+  ivSolutionCost = INFINITECOST;
+  ivSolutionForwardId = -1;
+  ivSolutionBackwardId = -1;
+  initSearch(&ivForwardSearch, true, ivStartId, ivGoalId);
+  initSearch(&ivBackwardSearch, false, ivGoalId, ivStartId);
+
+  ros::WallTime deadline =
+      ros::WallTime::now() + ros::WallDuration(allocated_time_sec);
+  // NOTE: if one of the OPEN lists runs empty all states reachable by
+  // this search have been connected to the other one
+  while (!ivForwardSearch.open.empty() && !ivBackwardSearch.open.empty())
+  {
+    // a cheaper path has to pass a state of each OPEN list, so both
+    // minimal f-values bound its costs (up to eps)
+    int min_f = std::max(ivForwardSearch.open.begin()->first,
+                         ivBackwardSearch.open.begin()->first);
+    if (ivSolutionCost <= min_f)
+      break;
+    if (ros::WallTime::now() > deadline)
+      break;
+
+    if (ivForwardSearch.open.size() <= ivBackwardSearch.open.size())
+      expandState(&ivForwardSearch, ivBackwardSearch);
+    else
+      expandState(&ivBackwardSearch, ivForwardSearch);
+  }
+
+  if (ivSolutionCost >= INFINITECOST)
+    return 0;
+
+  // follow the parents from the connection back to the start...
+  std::vector<int> path;
+  int id;
+  for (id = ivSolutionForwardId; id != -1;
+       id = ivForwardSearch.states[id].parent)
+  {
+    path.push_back(id);
+  }
+  solution_stateIDs_V->assign(path.rbegin(), path.rend());
+  // ...and forward to the goal
+  id = ivSolutionBackwardId;
+  if (id == ivSolutionForwardId)
+    id = ivBackwardSearch.states[id].parent;
+  for (; id != -1; id = ivBackwardSearch.states[id].parent)
+    solution_stateIDs_V->push_back(id);
+  *solcost = ivSolutionCost;
+
+  return 1;
+}
+
+
+void
+BidirectionalPlanner::initSearch(Search* search, bool forward,
+                                 int source_id, int target_id)
+{
+  search->forward = forward;
+  search->source_id = source_id;
+  search->target_id = target_id;
+  search->use_environment_heuristic =
+      ivEnvironment->heuristicToAnyState() ||
+      ivEnvironment->isForwardSearch() == forward;
+  State target;
+  ivEnvironment->getState(target_id, &target);
+  search->target_x = target.getX();
+  search->target_y = target.getY();
+
+  search->states.clear();
+  search->open.clear();
+  search->generated[RIGHT].clear();
+  search->generated[LEFT].clear();
+
+  SearchState& source = getSearchState(search, source_id);
+  source.g = 0;
+  source.f = int(ivEps * source.h);
+  search->open.insert(std::make_pair(source.f, source_id));
+  search->generated[source.leg][getBucket(source.x, source.y)].push_back(
+      source_id);
+}
+
+
+void
+BidirectionalPlanner::expandState(Search* search, const Search& other)
+{
+  int id = search->open.begin()->second;
+  search->open.erase(search->open.begin());
+  search->states[id].closed = true;
+  ++ivNumExpands;
+
+  // the g-value of an expanded state is final (states are not reopened)
+  connect(*search, other, id);
+
+  int g = search->states[id].g;
+  if (search->forward)
+    ivEnvironment->GetSuccs(id, &ivNeighborIds, &ivNeighborCosts);
+  else
+    ivEnvironment->GetPreds(id, &ivNeighborIds, &ivNeighborCosts);
+
+  for (size_t i = 0; i < ivNeighborIds.size(); ++i)
+  {
+    int neighbor_id = ivNeighborIds[i];
+    SearchState& neighbor = getSearchState(search, neighbor_id);
+    if (neighbor.closed)
+      continue;
+    int new_g = g + ivNeighborCosts[i];
+    if (new_g >= neighbor.g)
+      continue;
+
+    if (neighbor.g < INFINITECOST)
+    {
+      search->open.erase(std::make_pair(neighbor.f, neighbor_id));
+    }
+    else
+    {
+      search->generated[neighbor.leg][getBucket(neighbor.x, neighbor.y)]
+          .push_back(neighbor_id);
+    }
+    neighbor.g = new_g;
+    neighbor.f = new_g + int(ivEps * neighbor.h);
+    neighbor.parent = id;
+    search->open.insert(std::make_pair(neighbor.f, neighbor_id));
+  }
+}
+
+
+void
+BidirectionalPlanner::connect(const Search& search, const Search& other,
+                              int id)
+{
+  const SearchState& s = search.states[id];
+
+  // the state itself has been generated by the other search
+  if (size_t(id) < other.states.size() && other.states[id].g < INFINITECOST &&
+      s.g + other.states[id].g < ivSolutionCost)
+  {
+    ivSolutionCost = s.g + other.states[id].g;
+    ivSolutionForwardId = id;
+    ivSolutionBackwardId = id;
+  }
+
+  // a footstep changes the leg
+  const spatial_hash_t& generated = other.generated[s.leg == LEFT ? RIGHT :
+                                                                    LEFT];
+  std::pair<int, int> bucket = getBucket(s.x, s.y);
+  for (int dx = -1; dx <= 1; ++dx)
+  {
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+      spatial_hash_t::const_iterator bucket_iter = generated.find(
+          std::make_pair(bucket.first + dx, bucket.second + dy));
+      if (bucket_iter == generated.end())
+        continue;
+
+      std::vector<int>::const_iterator state_iter;
+      for (state_iter = bucket_iter->second.begin();
+           state_iter != bucket_iter->second.end();
+           ++state_iter)
+      {
+        int other_id = *state_iter;
+        int g = other.states[other_id].g;
+        if (s.g + g >= ivSolutionCost)
+          continue;
+
+        int step_cost = search.forward ?
+            ivEnvironment->getStepCost(id, other_id) :
+            ivEnvironment->getStepCost(other_id, id);
+        if (step_cost < 0 || s.g + step_cost + g >= ivSolutionCost)
+          continue;
+
+        ivSolutionCost = s.g + step_cost + g;
+        ivSolutionForwardId = search.forward ? id : other_id;
+        ivSolutionBackwardId = search.forward ? other_id : id;
+      }
+    }
+  }
+}
+
+
+BidirectionalPlanner::SearchState&
+BidirectionalPlanner::getSearchState(Search* search, int id)
+{
+  if (size_t(id) >= search->states.size())
+    search->states.resize(id + 1);
+
+  SearchState& s = search->states[id];
+  if (s.h < 0)
+  {
+    State state;
+    ivEnvironment->getState(id, &state);
+    s.x = state.getX();
+    s.y = state.getY();
+    s.leg = state.getLeg();
+
+    if (!search->use_environment_heuristic)
+    {
+      s.h = ivEnvironment->getStepCostLowerBound(s.x, s.y, search->target_x,
+                                                 search->target_y);
+    }
+    else if (search->forward)
+    {
+      s.h = ivEnvironment->GetGoalHeuristic(id);
+    }
+    else
+    {
+      s.h = ivEnvironment->GetStartHeuristic(id);
+    }
+  }
+  return s;
+}
+
+
+std::pair<int, int>
+BidirectionalPlanner::getBucket(double x, double y)
+const
+{
+  return std::make_pair(int(floor(x / ivBucketSize)),
+                        int(floor(y / ivBucketSize)));
+}
+
+
+int
+BidirectionalPlanner::set_goal(int goal_stateID)
+{
+  ivGoalId = goal_stateID;
+  return 1;
+}
+
+
+int
+BidirectionalPlanner::set_start(int start_stateID)
+{
+  ivStartId = start_stateID;
+  return 1;
+}
+
+
+int
+BidirectionalPlanner::force_planning_from_scratch()
+{
+  // replan() reinitializes both searches
+  return 1;
+}
+
+
+int
+BidirectionalPlanner::set_search_mode(bool bSearchUntilFirstSolution)
+{
+  // replan() stops at the first connection it cannot improve anymore
+  return 1;
+}
+
+
+void
+BidirectionalPlanner::costs_changed(const StateChangeQuery& stateChange)
+{
+  // the searches keep no information between calls of replan()
+}
+
+
+void
+BidirectionalPlanner::set_initialsolution_eps(double initialsolution_eps)
+{
+  ivEps = std::max(initialsolution_eps, 1.0);
+}
+}
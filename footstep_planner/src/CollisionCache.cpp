@@ -0,0 +1,92 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/CollisionCache.h>
+
+
+namespace footstep_planner
+{
+CollisionCache::CollisionCache(double cell_size, int num_angle_bins)
+: ivCellSize(cell_size),
+  ivNumAngleBins(num_angle_bins),
+  ivMinX(0),
+  ivMinY(0),
+  ivNumX(0),
+  ivNumY(0),
+  ivNumPagesAllocated(0),
+  ivNumLookups(0),
+  ivNumHits(0)
+{}
+
+
+CollisionCache::~CollisionCache()
+{}
+
+
+void
+CollisionCache::updateMap(gridmap_2d::GridMap2DPtr map)
+{
+  const nav_msgs::MapMetaData& info = map->getInfo();
+  double min_x = info.origin.position.x;
+  double min_y = info.origin.position.y;
+  double size_x = info.width * info.resolution;
+  double size_y = info.height * info.resolution;
+
+  // all cells overlapping the map
+  ivMinX = state_2_cell(min_x, ivCellSize);
+  ivMinY = state_2_cell(min_y, ivCellSize);
+  ivNumX = state_2_cell(min_x + size_x, ivCellSize) - ivMinX + 1;
+  ivNumY = state_2_cell(min_y + size_y, ivCellSize) - ivMinY + 1;
+
+  size_t num_entries = size_t(ivNumX) * ivNumY * ivNumAngleBins * 2;
+  size_t num_pages = (num_entries >> cvPageBits) + 1;
+  ivPages.clear();
+  ivPages.resize(num_pages);
+  ivNumPagesAllocated = 0;
+}
+
+
+void
+CollisionCache::insert(const PlanningState& s, bool occupied)
+{
+  size_t i;
+  if (!index(s, &i))
+    return;
+  std::vector<uint64_t>& page = ivPages[i >> cvPageBits];
+  if (page.empty())
+  {
+    page.assign(cvPageWords, 0);
+    ++ivNumPagesAllocated;
+  }
+
+  size_t j = i & ((size_t(1) << cvPageBits) - 1);
+  uint64_t entry = occupied ? OCCUPIED : FREE;
+  int shift = (j & 31) * 2;
+  page[j >> 5] = (page[j >> 5] & ~(uint64_t(3) << shift)) | (entry << shift);
+}
+
+
+void
+CollisionCache::resetStatistics()
+{
+  ivNumLookups = 0;
+  ivNumHits = 0;
+}
+}
@@ -0,0 +1,221 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/CollisionLayers.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+
+namespace footstep_planner
+{
+CollisionLayers::CollisionLayers(double footsize_x, double footsize_y,
+                                 double foot_origin_shift_x,
+                                 double foot_origin_shift_y,
+                                 int num_angle_bins, size_t max_memory)
+: ivFootsizeX(footsize_x),
+  ivFootsizeY(footsize_y),
+  ivFootOriginShiftX(foot_origin_shift_x),
+  ivFootOriginShiftY(foot_origin_shift_y),
+  ivNumAngleBins(num_angle_bins),
+  ivMaxMemory(max_memory),
+  ivLayerSize(0),
+  ivNumLayersBuilt(0)
+{}
+
+
+CollisionLayers::~CollisionLayers()
+{}
+
+
+void
+CollisionLayers::updateMap(gridmap_2d::GridMap2DPtr map)
+{
+  ivMapPtr = map;
+
+  ivLayers.clear();
+  ivLayers.resize(2 * ivNumAngleBins);
+  size_t num_cells = size_t(ivMapPtr->getInfo().width) *
+                     ivMapPtr->getInfo().height;
+  ivLayerSize = (num_cells + 63) / 64;
+  ivNumLayersBuilt = 0;
+}
+
+
+bool
+CollisionLayers::lookup(double x, double y, int theta, Leg leg,
+                        bool* occupied)
+{
+  size_t index = layerIndex(theta, leg);
+  Layer& layer = ivLayers[index];
+  // the layer may be built concurrently by another thread
+  if (!__atomic_load_n(&layer.built, __ATOMIC_ACQUIRE))
+  {
+    // cheap test first to avoid locking once the memory limit is reached
+    if (getMemoryUsage() + ivLayerSize * sizeof(uint64_t) > ivMaxMemory ||
+        !reserveLayer(index))
+      return false;
+    buildLayer(index);
+  }
+
+  unsigned int mx, my;
+  if (!ivMapPtr->worldToMap(x, y, mx, my))
+  {
+    // out of bounds => collision
+    *occupied = true;
+    return true;
+  }
+
+  size_t bit = size_t(mx) * ivMapPtr->getInfo().height + my;
+  *occupied = (layer.bits[bit >> 6] >> (bit & 63)) & 1;
+  return true;
+}
+
+
+void
+CollisionLayers::buildAll(int num_threads)
+{
+  ros::WallTime start_time = ros::WallTime::now();
+
+  // reserve the memory of all layers in order of the angle bins (until the
+  // memory limit is reached)
+  std::vector<size_t> indices;
+  for (int theta = 0; theta < ivNumAngleBins; ++theta)
+  {
+    size_t index = layerIndex(theta, RIGHT);
+    if (reserveLayer(index))
+      indices.push_back(index);
+    if (layerIndex(theta, LEFT) != index &&
+        reserveLayer(layerIndex(theta, LEFT)))
+    {
+      indices.push_back(layerIndex(theta, LEFT));
+    }
+  }
+
+  size_t next_index = 0;
+  boost::thread_group threads;
+  for (int i = 0; i < std::max(num_threads, 1); ++i)
+  {
+    threads.create_thread(boost::bind(&CollisionLayers::buildLayers, this,
+                                      &indices, &next_index));
+  }
+  threads.join_all();
+
+  ROS_INFO("Built %zu collision layers (%zu MB) in %f s.", indices.size(),
+           getMemoryUsage() / (1024 * 1024),
+           (ros::WallTime::now() - start_time).toSec());
+}
+
+
+void
+CollisionLayers::buildLayers(const std::vector<size_t>* indices,
+                             size_t* next_index)
+{
+  while (true)
+  {
+    size_t index;
+    {
+      boost::mutex::scoped_lock lock(ivMutex);
+      if (*next_index >= indices->size())
+        return;
+      index = (*indices)[(*next_index)++];
+    }
+    buildLayer(index);
+  }
+}
+
+
+bool
+CollisionLayers::reserveLayer(size_t index)
+{
+  boost::mutex::scoped_lock lock(ivMutex);
+
+  Layer& layer = ivLayers[index];
+  // already built or reserved
+  if (!layer.bits.empty())
+    return false;
+  if ((ivNumLayersBuilt + 1) * ivLayerSize * sizeof(uint64_t) > ivMaxMemory)
+    return false;
+
+  layer.bits.assign(ivLayerSize, 0);
+  __atomic_store_n(&ivNumLayersBuilt, ivNumLayersBuilt + 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+
+void
+CollisionLayers::buildLayer(size_t index)
+{
+  int theta = index / 2;
+  Leg leg = (index % 2) ? LEFT : RIGHT;
+
+  double resolution = ivMapPtr->getResolution();
+  double theta_cont = angle_cell_2_state(theta, ivNumAngleBins);
+  double theta_cos = cos(theta_cont);
+  double theta_sin = sin(theta_cont);
+  double shift_x = ivFootOriginShiftX;
+  double shift_y = (leg == LEFT) ? ivFootOriginShiftY : -ivFootOriginShiftY;
+  // the foot is inflated by one map cell (same as in collision_check())
+  double half_x = ivFootsizeX / 2.0 + resolution;
+  double half_y = ivFootsizeY / 2.0 + resolution;
+
+  // the kernel contains all map cells covered by the foot (relative to
+  // the foot's origin in its center)
+  double max_x = fabs(shift_x) + half_x;
+  double max_y = fabs(shift_y) + half_y;
+  int r = int(ceil(sqrt(max_x*max_x + max_y*max_y) / resolution));
+  cv::Mat kernel = cv::Mat::zeros(2*r + 1, 2*r + 1, CV_8UC1);
+  for (int i = -r; i <= r; ++i)
+  {
+    for (int j = -r; j <= r; ++j)
+    {
+      double p_x = i * resolution;
+      double p_y = j * resolution;
+      // transform into the frame of the foot's center
+      double foot_x = theta_cos*p_x + theta_sin*p_y - shift_x;
+      double foot_y = -theta_sin*p_x + theta_cos*p_y - shift_y;
+      if (fabs(foot_x) <= half_x && fabs(foot_y) <= half_y)
+        kernel.at<uchar>(i + r, j + r) = 1;
+    }
+  }
+  // the origin itself has to be free as well
+  kernel.at<uchar>(r, r) = 1;
+
+  // NOTE: the cv::Mat of the binary map stores x as rows and y as columns;
+  // cells outside of the map are considered as occupied
+  cv::Mat free_space;
+  cv::erode(ivMapPtr->binaryMap(), free_space, kernel, cv::Point(r, r), 1,
+            cv::BORDER_CONSTANT, cv::Scalar(0));
+
+  Layer& layer = ivLayers[index];
+  for (int x = 0; x < free_space.rows; ++x)
+  {
+    const uchar* row = free_space.ptr<uchar>(x);
+    size_t bit = size_t(x) * free_space.cols;
+    for (int y = 0; y < free_space.cols; ++y, ++bit)
+    {
+      if (row[y] < 255)
+        layer.bits[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+  }
+  // publish the bits to lookups on other threads
+  __atomic_store_n(&layer.built, true, __ATOMIC_RELEASE);
+}
+}
@@ -24,15 +24,12 @@
 namespace footstep_planner
 {
 Footstep::Footstep(double x, double y, double theta, double cell_size,
-                   int num_angle_bins, int max_hash_size)
+                   int num_angle_bins)
 : ivTheta(angle_state_2_cell(theta, num_angle_bins)),
   ivCellSize(cell_size),
   ivNumAngleBins(num_angle_bins),
-  ivMaxHashSize(max_hash_size),
-  ivDiscSuccessorLeft(num_angle_bins),
-  ivDiscSuccessorRight(num_angle_bins),
-  ivDiscPredecessorLeft(num_angle_bins),
-  ivDiscPredecessorRight(num_angle_bins)
+  ivSuccessorKeyDelta(num_angle_bins << STATE_KEY_LEG_BITS, 0),
+  ivPredecessorKeyDelta(num_angle_bins << STATE_KEY_LEG_BITS, 0)
 {
   init(x, y);
 }
@@ -49,18 +46,29 @@ Footstep::init(double x, double y)
   int footstep_x;
   int footstep_y;
 
+  // NOTE: the leg changes with each footstep (RIGHT <-> LEFT), the rotation
+  // is stored as the difference of the angle bins to account for the wrap
+  // around at ivNumAngleBins
   for (int a = 0; a < ivNumAngleBins; ++a)
   {
     backward_angle = calculateForwardStep(RIGHT, a, x, y,
                                           &footstep_x, &footstep_y);
-    ivDiscSuccessorRight[a] = footstep_xy(footstep_x, footstep_y);
-    ivDiscPredecessorLeft[backward_angle] = footstep_xy(-footstep_x,
-                                                        -footstep_y);
+    ivSuccessorKeyDelta[deltaIndex(PlanningState(0, 0, a, RIGHT))] =
+        calc_state_key_delta(footstep_x, footstep_y, backward_angle - a,
+                             LEFT - RIGHT);
+    ivPredecessorKeyDelta[deltaIndex(PlanningState(0, 0, backward_angle,
+                                                   LEFT))] =
+        calc_state_key_delta(-footstep_x, -footstep_y, a - backward_angle,
+                             RIGHT - LEFT);
     backward_angle = calculateForwardStep(LEFT, a, x, y,
                                           &footstep_x, &footstep_y);
-    ivDiscSuccessorLeft[a] = footstep_xy(footstep_x, footstep_y);
-    ivDiscPredecessorRight[backward_angle] = footstep_xy(-footstep_x,
-                                                         -footstep_y);
+    ivSuccessorKeyDelta[deltaIndex(PlanningState(0, 0, a, LEFT))] =
+        calc_state_key_delta(footstep_x, footstep_y, backward_angle - a,
+                             RIGHT - LEFT);
+    ivPredecessorKeyDelta[deltaIndex(PlanningState(0, 0, backward_angle,
+                                                   RIGHT))] =
+        calc_state_key_delta(-footstep_x, -footstep_y, a - backward_angle,
+                             LEFT - RIGHT);
   }
 }
 
@@ -69,36 +77,8 @@ PlanningState
 Footstep::performMeOnThisState(const PlanningState& current)
 const
 {
-  Leg leg;
-
-  int x = current.getX();
-  int y = current.getY();
-  int theta = current.getTheta();
-
-  if (current.getLeg() == RIGHT)
-  {
-    footstep_xy xy = ivDiscSuccessorRight[theta];
-    x += xy.first;
-    y += xy.second;
-    theta += ivTheta;
-    leg = LEFT;
-  }
-  else // leg == LEFT
-  {
-    footstep_xy xy = ivDiscSuccessorLeft[theta];
-    x += xy.first;
-    y += xy.second;
-    theta -= ivTheta;
-    leg = RIGHT;
-  }
-
-  // theta has to be in [0..ivNumAngleBins)
-  if (theta < 0)
-    theta += ivNumAngleBins;
-  else if (theta >= ivNumAngleBins)
-    theta -= ivNumAngleBins;
-
-  return PlanningState(x, y, theta, leg, ivMaxHashSize);
+  return PlanningState(current.getKey() +
+                       ivSuccessorKeyDelta[deltaIndex(current)]);
 }
 
 
@@ -106,35 +86,8 @@ PlanningState
 Footstep::reverseMeOnThisState(const PlanningState& current)
 const
 {
-  Leg leg;
-
-  int x = current.getX();
-  int y = current.getY();
-  int theta = current.getTheta();
-
-  if (current.getLeg() == LEFT)
-  {
-    footstep_xy xy = ivDiscPredecessorLeft[theta];
-    x += xy.first;
-    y += xy.second;
-    theta -= ivTheta;
-    leg = RIGHT;
-  }
-  else // leg == RIGHT
-  {
-    footstep_xy xy = ivDiscPredecessorRight[theta];
-    x += xy.first;
-    y += xy.second;
-    theta += ivTheta;
-    leg = LEFT;
-  }
-  // theta has to be in [0..ivNumAngleBins)
-  if (theta < 0)
-    theta += ivNumAngleBins;
-  else if (theta >= ivNumAngleBins)
-    theta -= ivNumAngleBins;
-
-  return PlanningState(x, y, theta, leg, ivMaxHashSize);
+  return PlanningState(current.getKey() +
+                       ivPredecessorKeyDelta[deltaIndex(current)]);
 }
 
 
@@ -52,14 +52,15 @@ FootstepPlanner::FootstepPlanner()
   ivStartPoseVisPub = nh_private.advertise<
       geometry_msgs::PoseStamped>("start", 1);
 
-  std::string heuristic_type;
-  double diff_angle_cost;
-
   // read parameters from config file:
   // planner environment settings
-  nh_private.param("heuristic_type", heuristic_type,
+  nh_private.param("heuristic_type", ivHeuristicType,
                    std::string("EuclideanHeuristic"));
   nh_private.param("heuristic_scale", ivEnvironmentParams.heuristic_scale, 1.0);
+  nh_private.param("heuristic_cache/size", ivHeuristicCacheSize, 4);
+  nh_private.param("heuristic_cache/max_memory", ivHeuristicCacheMaxMemory,
+                   64);
+  nh_private.param("heuristic_threads", ivHeuristicThreads, 4);
   nh_private.param("max_hash_size", ivEnvironmentParams.hash_table_size, 65536);
   nh_private.param("accuracy/collision_check",
                    ivEnvironmentParams.collision_check_accuracy,
@@ -68,26 +69,61 @@ FootstepPlanner::FootstepPlanner()
   nh_private.param("accuracy/num_angle_bins",
                    ivEnvironmentParams.num_angle_bins,
                    64);
+  nh_private.param("collision_layers/enabled",
+                   ivEnvironmentParams.collision_layers, false);
+  nh_private.param("collision_layers/threads",
+                   ivEnvironmentParams.collision_layers_threads, 0);
+  nh_private.param("collision_layers/max_memory",
+                   ivEnvironmentParams.collision_layers_max_memory, 512);
+  nh_private.param("collision_cache", ivEnvironmentParams.collision_cache,
+                   true);
+  nh_private.param("collision_threads", ivEnvironmentParams.collision_threads,
+                   0);
+  nh_private.param("lazy_collision_check",
+                   ivEnvironmentParams.lazy_collision_check, false);
+  nh_private.param("step_cost_table/file",
+                   ivEnvironmentParams.step_cost_table, std::string(""));
   nh_private.param("step_cost", ivEnvironmentParams.step_cost, 0.05);
-  nh_private.param("diff_angle_cost", diff_angle_cost, 0.0);
+  nh_private.param("diff_angle_cost", ivDiffAngleCost, 0.0);
 
   nh_private.param("planner_type", ivPlannerType, std::string("ARAPlanner"));
+  nh_private.param("pase/threads", ivPASEThreads, 8);
+  nh_private.param("pase/independence_eps", ivPASEIndependenceEps, 1.0);
   nh_private.param("search_until_first_solution", ivSearchUntilFirstSolution,
                    false);
   nh_private.param("allocated_time", ivMaxSearchTime, 7.0);
+  nh_private.param("anytime_streaming/enabled", ivAnytimeStreaming, false);
+  nh_private.param("anytime_streaming/interval", ivAnytimeStreamingInterval,
+                   0.1);
   nh_private.param("forward_search", ivEnvironmentParams.forward_search, false);
   nh_private.param("initial_epsilon", ivInitialEpsilon, 3.0);
+  ivEnvironmentParams.max_epsilon =
+      ivInitialEpsilon * std::max(ivPASEIndependenceEps, 1.0);
   nh_private.param("changed_cells_limit", ivChangedCellsLimit, 20000);
+  nh_private.param("warm_start/enabled", ivWarmStart, false);
+  nh_private.param("warm_start/max_memory", ivWarmStartMaxMemory, 256);
   nh_private.param("num_random_nodes", ivEnvironmentParams.num_random_nodes,
                    20);
   nh_private.param("random_node_dist", ivEnvironmentParams.random_node_distance,
                    1.0);
+  nh_private.param("hierarchical/enabled", ivHierarchical, false);
+  double coarse_cell_size;
+  int coarse_num_angle_bins;
+  nh_private.param("hierarchical/cell_size", coarse_cell_size, 0.05);
+  nh_private.param("hierarchical/num_angle_bins", coarse_num_angle_bins, 16);
+  nh_private.param("hierarchical/corridor_width", ivCorridorWidth, 0.3);
+  nh_private.param("hierarchical/coarse_search_time", ivCoarseSearchTime,
+                   1.0);
+  nh_private.param("heuristic_corridor/enabled", ivHeuristicCorridor, false);
+  nh_private.param("heuristic_corridor/width", ivHeuristicCorridorWidth, 0.5);
+  nh_private.param("max_corridor_width", ivMaxCorridorWidth, 2.0);
 
   // footstep settings
   nh_private.param("foot/size/x", ivEnvironmentParams.footsize_x, 0.16);
   nh_private.param("foot/size/y", ivEnvironmentParams.footsize_y, 0.06);
   nh_private.param("foot/size/z", ivEnvironmentParams.footsize_z, 0.015);
   nh_private.param("foot/separation", ivFootSeparation, 0.1);
+  ivEnvironmentParams.foot_separation = ivFootSeparation;
   nh_private.param("foot/origin_shift/x",
                    ivEnvironmentParams.foot_origin_shift_x,
                    0.02);
@@ -131,25 +167,21 @@ FootstepPlanner::FootstepPlanner()
               "Exit!");
     exit(2);
   }
-  // create footstep set
-  ivEnvironmentParams.footstep_set.clear();
-  double max_step_width = 0;
+  // footstep set
+  ivFootsteps.clear();
+  ivMaxFootstepWidth = 0;
   for(int i=0; i < footsteps_x.size(); ++i)
   {
     double x = (double)footsteps_x[i];
     double y = (double)footsteps_y[i];
     double theta = (double)footsteps_theta[i];
 
-    Footstep f(x, y, theta,
-               ivEnvironmentParams.cell_size,
-               ivEnvironmentParams.num_angle_bins,
-               ivEnvironmentParams.hash_table_size);
-    ivEnvironmentParams.footstep_set.push_back(f);
+    ivFootsteps.push_back(State(x, y, theta, NOLEG));
 
     double cur_step_width = sqrt(x*x + y*y);
 
-    if (cur_step_width > max_step_width)
-      max_step_width = cur_step_width;
+    if (cur_step_width > ivMaxFootstepWidth)
+      ivMaxFootstepWidth = cur_step_width;
   }
 
   // step range
@@ -166,13 +198,11 @@ FootstepPlanner::FootstepPlanner()
     ROS_ERROR("Step range points have different size. Exit!");
     exit(2);
   }
-  // create step range
-  ivEnvironmentParams.step_range.clear();
-  ivEnvironmentParams.step_range.reserve(step_range_x.size());
+  ivStepRange.clear();
+  ivStepRange.reserve(step_range_x.size());
   double x, y;
   double max_x = 0.0;
   double max_y = 0.0;
-  double cell_size = ivEnvironmentParams.cell_size;
   for (int i=0; i < step_range_x.size(); ++i)
   {
     x = (double)step_range_x[i];
@@ -181,71 +211,76 @@ FootstepPlanner::FootstepPlanner()
       max_x = fabs(x);
     if (fabs(y) > max_y)
       max_y = fabs(y);
-    ivEnvironmentParams.step_range.push_back(
-      std::pair<int, int>(disc_val(x, cell_size), disc_val(y, cell_size)));
+    ivStepRange.push_back(std::pair<double, double>(x, y));
   }
-  // insert first point again at the end!
-  ivEnvironmentParams.step_range.push_back(ivEnvironmentParams.step_range[0]);
   ivEnvironmentParams.max_step_width = sqrt(max_x*max_x + max_y*max_y) * 1.5;
 
+  // discretize the footsteps and the step range
+  discretizeFootsteps(&ivEnvironmentParams);
+
   // initialize the heuristic
-  boost::shared_ptr<Heuristic> h;
-  if (heuristic_type == "EuclideanHeuristic")
-  {
-    h.reset(
-        new EuclideanHeuristic(ivEnvironmentParams.cell_size,
-                               ivEnvironmentParams.num_angle_bins));
-    ROS_INFO("FootstepPlanner heuristic: euclidean distance");
-  }
-  else if(heuristic_type == "EuclStepCostHeuristic")
+  ivEnvironmentParams.heuristic = createHeuristic(ivEnvironmentParams);
+  // keep a local ptr for visualization
+  ivPathCostHeuristicPtr = boost::dynamic_pointer_cast<PathCostHeuristic>(
+      ivEnvironmentParams.heuristic);
+
+  // NOTE: the collision layers hold the exact foot shape (accuracy 2), with
+  // a lower accuracy they would change which poses are colliding
+  if (ivEnvironmentParams.collision_layers &&
+      ivEnvironmentParams.collision_check_accuracy != 2)
   {
-    h.reset(
-        new EuclStepCostHeuristic(ivEnvironmentParams.cell_size,
-                                  ivEnvironmentParams.num_angle_bins,
-                                  ivEnvironmentParams.step_cost,
-                                  diff_angle_cost,
-                                  max_step_width));
-    ROS_INFO("FootstepPlanner heuristic: euclidean distance with step costs");
+    ROS_WARN("The collision layers require a collision check accuracy of 2 "
+             "(is %d), disabling them.",
+             ivEnvironmentParams.collision_check_accuracy);
+    ivEnvironmentParams.collision_layers = false;
   }
-  else if (heuristic_type == "PathCostHeuristic")
+  // NOTE: the AD planner's incremental updates require the collision checks
+  // of all neighbors, the bidirectional planner connects generated states
+  if (ivEnvironmentParams.lazy_collision_check &&
+      (ivPlannerType == "ADPlanner" ||
+       ivPlannerType == "BidirectionalPlanner"))
   {
-    // for heuristic inflation
-    double foot_incircle =
-      std::min((ivEnvironmentParams.footsize_x / 2.0 -
-                std::abs(ivEnvironmentParams.foot_origin_shift_x)),
-               (ivEnvironmentParams.footsize_y / 2.0 -
-                std::abs(ivEnvironmentParams.foot_origin_shift_y)));
-    assert(foot_incircle > 0.0);
-
-    h.reset(
-        new PathCostHeuristic(ivEnvironmentParams.cell_size,
-                              ivEnvironmentParams.num_angle_bins,
-                              ivEnvironmentParams.step_cost,
-                              diff_angle_cost,
-                              max_step_width,
-                              foot_incircle));
-    ROS_INFO("FootstepPlanner heuristic: 2D path euclidean distance with step "
-             "costs");
-
-    // keep a local ptr for visualization
-    ivPathCostHeuristicPtr = boost::dynamic_pointer_cast<PathCostHeuristic>(h);
+    ROS_WARN_STREAM("Lazy collision checks are not supported by the "
+                    << ivPlannerType << ", disabling them.");
+    ivEnvironmentParams.lazy_collision_check = false;
   }
-  else
+  // NOTE: only the ARA* search is resumed where it has been interrupted
+  if (ivAnytimeStreaming && ivPlannerType != "ARAPlanner")
   {
-    ROS_ERROR_STREAM("Heuristic " << heuristic_type << " not available, "
-                     "exiting.");
-    exit(1);
+    ROS_WARN_STREAM("Streaming the solutions is not supported by the "
+                    << ivPlannerType << ", disabling it.");
+    ivAnytimeStreaming = false;
   }
-  ivEnvironmentParams.heuristic = h;
 
   // initialize the planner environment
   ivPlannerEnvironmentPtr.reset(
-    new FootstepPlannerEnvironment(ivEnvironmentParams));
+    FootstepPlannerEnvironment::create(ivEnvironmentParams));
+
+  // initialize the environment of the coarse planning stage which uses the
+  // same footsteps discretized at a lower resolution
+  if (ivHierarchical)
+  {
+    ivCoarseEnvironmentParams = ivEnvironmentParams;
+    ivCoarseEnvironmentParams.cell_size = coarse_cell_size;
+    ivCoarseEnvironmentParams.num_angle_bins = coarse_num_angle_bins;
+    // the step cost table is only valid for the planning lattice
+    ivCoarseEnvironmentParams.step_cost_table = "";
+    discretizeFootsteps(&ivCoarseEnvironmentParams);
+    ivCoarseEnvironmentParams.heuristic =
+        createHeuristic(ivCoarseEnvironmentParams);
+    ivCoarseEnvironmentPtr.reset(
+        FootstepPlannerEnvironment::create(ivCoarseEnvironmentParams));
+    ROS_INFO("Hierarchical planning: coarse cell size %f, %d angle bins, "
+             "corridor width %f", coarse_cell_size, coarse_num_angle_bins,
+             ivCorridorWidth);
+  }
 
   // set up planner
   if (ivPlannerType == "ARAPlanner" ||
       ivPlannerType == "ADPlanner"  ||
-      ivPlannerType == "RSTARPlanner" )
+      ivPlannerType == "RSTARPlanner" ||
+      ivPlannerType == "PASEPlanner" ||
+      ivPlannerType == "BidirectionalPlanner")
   {
     ROS_INFO_STREAM("Planning with " << ivPlannerType);
   }
@@ -255,7 +290,11 @@ FootstepPlanner::FootstepPlanner()
                      "untested.");
     exit(1);
   }
-  if (ivEnvironmentParams.forward_search)
+  if (ivPlannerType == "BidirectionalPlanner")
+  {
+    ROS_INFO_STREAM("Search direction: bidirectional planning");
+  }
+  else if (ivEnvironmentParams.forward_search)
   {
     ROS_INFO_STREAM("Search direction: forward planning");
   }
@@ -296,12 +335,247 @@ FootstepPlanner::setPlanner()
     //          p->set_eps_step(1.0);
     ivPlannerPtr.reset(p);
   }
+  else if (ivPlannerType == "PASEPlanner")
+  {
+    ivPlannerPtr.reset(
+        new PASEPlanner(ivPlannerEnvironmentPtr.get(),
+                        ivEnvironmentParams.forward_search,
+                        ivPASEThreads, ivPASEIndependenceEps));
+  }
+  else if (ivPlannerType == "BidirectionalPlanner")
+  {
+    ivPlannerPtr.reset(
+        new BidirectionalPlanner(ivPlannerEnvironmentPtr.get()));
+  }
   //        else if (ivPlannerType == "ANAPlanner")
   //        	ivPlannerPtr.reset(new anaPlanner(ivPlannerEnvironmentPtr.get(),
   //        	                                  ivForwardSearch));
 }
 
 
+void
+FootstepPlanner::discretizeFootsteps(environment_params* params)
+const
+{
+  params->footstep_set.clear();
+  params->footstep_set.reserve(ivFootsteps.size());
+  std::vector<State>::const_iterator footstep_iter;
+  for (footstep_iter = ivFootsteps.begin();
+       footstep_iter != ivFootsteps.end();
+       ++footstep_iter)
+  {
+    params->footstep_set.push_back(
+        Footstep(footstep_iter->getX(), footstep_iter->getY(),
+                 footstep_iter->getTheta(),
+                 params->cell_size, params->num_angle_bins));
+  }
+
+  params->step_range.clear();
+  params->step_range.reserve(ivStepRange.size() + 1);
+  std::vector<std::pair<double, double> >::const_iterator step_range_iter;
+  for (step_range_iter = ivStepRange.begin();
+       step_range_iter != ivStepRange.end();
+       ++step_range_iter)
+  {
+    params->step_range.push_back(
+        std::pair<int, int>(disc_val(step_range_iter->first,
+                                     params->cell_size),
+                            disc_val(step_range_iter->second,
+                                     params->cell_size)));
+  }
+  // insert first point again at the end!
+  params->step_range.push_back(params->step_range[0]);
+}
+
+
+boost::shared_ptr<Heuristic>
+FootstepPlanner::createHeuristic(const environment_params& params)
+const
+{
+  boost::shared_ptr<Heuristic> h;
+  if (ivHeuristicType == "EuclideanHeuristic")
+  {
+    h.reset(new EuclideanHeuristic(params.cell_size, params.num_angle_bins));
+    ROS_INFO("FootstepPlanner heuristic: euclidean distance");
+  }
+  else if(ivHeuristicType == "EuclStepCostHeuristic")
+  {
+    h.reset(
+        new EuclStepCostHeuristic(params.cell_size,
+                                  params.num_angle_bins,
+                                  params.step_cost,
+                                  ivDiffAngleCost,
+                                  ivMaxFootstepWidth));
+    ROS_INFO("FootstepPlanner heuristic: euclidean distance with step costs");
+  }
+  else if (ivHeuristicType == "PathCostHeuristic" ||
+           ivHeuristicType == "ParallelPathCostHeuristic")
+  {
+    // for heuristic inflation
+    double foot_incircle =
+      std::min((params.footsize_x / 2.0 -
+                std::abs(params.foot_origin_shift_x)),
+               (params.footsize_y / 2.0 -
+                std::abs(params.foot_origin_shift_y)));
+    assert(foot_incircle > 0.0);
+
+    PathCostHeuristic* path_cost_heuristic =
+        new PathCostHeuristic(params.cell_size,
+                              params.num_angle_bins,
+                              params.step_cost,
+                              ivDiffAngleCost,
+                              ivMaxFootstepWidth,
+                              foot_incircle,
+                              ivHeuristicCacheSize,
+                              ivHeuristicCacheMaxMemory * 1024 * 1024);
+    h.reset(path_cost_heuristic);
+    if (ivHeuristicType == "ParallelPathCostHeuristic")
+    {
+      path_cost_heuristic->useGridDistanceField(ivHeuristicThreads);
+      ROS_INFO("FootstepPlanner heuristic: 2D path euclidean distance with "
+               "step costs (%d threads)", ivHeuristicThreads);
+    }
+    else
+    {
+      ROS_INFO("FootstepPlanner heuristic: 2D path euclidean distance with "
+               "step costs");
+    }
+  }
+  else
+  {
+    ROS_ERROR_STREAM("Heuristic " << ivHeuristicType << " not available, "
+                     "exiting.");
+    exit(1);
+  }
+  return h;
+}
+
+
+bool
+FootstepPlanner::planCoarse(std::vector<std::pair<double, double> >* path)
+{
+  path->clear();
+
+  ivCoarseEnvironmentPtr->reset();
+  ivCoarseEnvironmentPtr->updateStart(ivStartFootLeft, ivStartFootRight);
+  ivCoarseEnvironmentPtr->updateGoal(ivGoalFootLeft, ivGoalFootRight);
+  ivCoarseEnvironmentPtr->updateHeuristicValues();
+  ivCoarseEnvironmentPtr->InitializeEnv(NULL);
+  MDPConfig mdp_config;
+  ivCoarseEnvironmentPtr->InitializeMDPCfg(&mdp_config);
+
+  // the coarse path only guides the fine search, so the first solution
+  // suffices
+  ARAPlanner planner(ivCoarseEnvironmentPtr.get(),
+                     ivCoarseEnvironmentParams.forward_search);
+  if (planner.set_start(mdp_config.startstateid) == 0 ||
+      planner.set_goal(mdp_config.goalstateid) == 0)
+  {
+    return false;
+  }
+  planner.set_initialsolution_eps(ivInitialEpsilon);
+  planner.set_search_mode(true);
+
+  std::vector<int> solution_state_ids;
+  int path_cost;
+  int ret = 0;
+  try
+  {
+    ret = planner.replan(ivCoarseSearchTime, &solution_state_ids, &path_cost);
+  }
+  catch (const SBPL_Exception& e)
+  {
+    return false;
+  }
+  if (!ret || solution_state_ids.empty())
+    return false;
+
+  path->reserve(solution_state_ids.size());
+  State s;
+  std::vector<int>::const_iterator state_ids_iter;
+  for (state_ids_iter = solution_state_ids.begin();
+       state_ids_iter != solution_state_ids.end();
+       ++state_ids_iter)
+  {
+    if (ivCoarseEnvironmentPtr->getState(*state_ids_iter, &s))
+      path->push_back(std::pair<double, double>(s.getX(), s.getY()));
+  }
+  ROS_INFO("Coarse path of size %zu found (%i expanded states)",
+           path->size(), ivCoarseEnvironmentPtr->getNumExpandedStates());
+  return true;
+}
+
+
+int
+FootstepPlanner::search(const MDPConfig& mdp_config, double max_time,
+                        std::vector<int>* solution_state_ids, int* path_cost)
+{
+  if (ivPlannerPtr->set_start(mdp_config.startstateid) == 0)
+  {
+    ROS_ERROR("Failed to set start state.");
+    return 0;
+  }
+  if (ivPlannerPtr->set_goal(mdp_config.goalstateid) == 0)
+  {
+    ROS_ERROR("Failed to set goal state\n");
+    return 0;
+  }
+
+  ivPlannerPtr->set_initialsolution_eps(ivInitialEpsilon);
+  ivPlannerPtr->set_search_mode(ivSearchUntilFirstSolution);
+
+  ROS_INFO("Start planning (max time: %f, initial eps: %f (%f))\n",
+           max_time, ivInitialEpsilon, ivPlannerPtr->get_initial_eps());
+  try
+  {
+    if (!ivAnytimeStreaming || ivSearchUntilFirstSolution)
+      return ivPlannerPtr->replan(max_time, solution_state_ids, path_cost);
+
+    // anytime streaming: ARA* is run in short time slices, each call
+    // continues the previous search and returns the best solution so far
+    ros::WallTime deadline =
+        ros::WallTime::now() + ros::WallDuration(max_time);
+    std::vector<int> state_ids;
+    int cost;
+    int best_cost = INFINITECOST;
+    while (true)
+    {
+      double remaining_time = (deadline - ros::WallTime::now()).toSec();
+      if (remaining_time <= 0.0)
+        break;
+
+      int num_expanded_states =
+          ivPlannerEnvironmentPtr->getNumExpandedStates();
+      if (ivPlannerPtr->replan(
+              std::min(ivAnytimeStreamingInterval, remaining_time),
+              &state_ids, &cost) &&
+          !state_ids.empty() && cost < best_cost)
+      {
+        best_cost = cost;
+        *solution_state_ids = state_ids;
+        *path_cost = cost;
+        streamSolution(state_ids, cost);
+      }
+
+      // the search has finished if the solution is optimal or no state
+      // is left to expand
+      if (ivPlannerPtr->get_solution_eps() <= 1.0 ||
+          num_expanded_states ==
+              ivPlannerEnvironmentPtr->getNumExpandedStates())
+      {
+        break;
+      }
+    }
+    return best_cost < INFINITECOST;
+  }
+  catch (const SBPL_Exception& e)
+  {
+    // ROS_ERROR("SBPL planning failed (%s)", e.what());
+    return 0;
+  }
+}
+
+
 bool
 FootstepPlanner::run()
 {
@@ -310,6 +584,26 @@ FootstepPlanner::run()
   MDPConfig mdp_config;
   std::vector<int> solution_state_ids;
 
+  // the expanded states are only needed for the visualization
+  ivPlannerEnvironmentPtr->setTrackExpandedStates(
+      ivExpandedStatesVisPub.getNumSubscribers() > 0);
+
+  // hierarchical planning: restrict the search to a corridor around the
+  // path found on the coarse lattice
+  ros::WallTime startTime = ros::WallTime::now();
+  ivPlanningStartTime = startTime;
+  double coarse_time = 0.0;
+  std::vector<std::pair<double, double> > corridor_path;
+  double corridor_width = 0.0;
+  if (ivHierarchical)
+  {
+    if (planCoarse(&corridor_path))
+      corridor_width = ivCorridorWidth;
+    else
+      ROS_INFO("No coarse path found, planning without corridor.");
+    coarse_time = (ros::WallTime::now() - startTime).toSec();
+  }
+
   // commit start/goal poses to the environment
   ivPlannerEnvironmentPtr->updateStart(ivStartFootLeft, ivStartFootRight);
   ivPlannerEnvironmentPtr->updateGoal(ivGoalFootLeft, ivGoalFootRight);
@@ -317,6 +611,20 @@ FootstepPlanner::run()
   ivPlannerEnvironmentPtr->InitializeEnv(NULL);
   ivPlannerEnvironmentPtr->InitializeMDPCfg(&mdp_config);
 
+  // ..or to a corridor around the 2D path of the heuristic (available after
+  // the heuristic values have been updated)
+  if (!ivHierarchical && ivHeuristicCorridor)
+  {
+    if (getHeuristicPath(&corridor_path))
+      corridor_width = ivHeuristicCorridorWidth;
+    else
+      ROS_INFO("No 2D path found, planning without corridor.");
+  }
+  if (corridor_width > 0.0)
+    ivPlannerEnvironmentPtr->setCorridor(corridor_path, corridor_width);
+  else
+    ivPlannerEnvironmentPtr->clearCorridor();
+
   // inform AD planner about changed (start) states for replanning
   if (path_existed &&
       !ivEnvironmentParams.forward_search &&
@@ -330,35 +638,36 @@ FootstepPlanner::run()
     ad_planner->update_preds_of_changededges(&changed_edges);
   }
 
-  // set up SBPL
-  if (ivPlannerPtr->set_start(mdp_config.startstateid) == 0)
+  int path_cost = 0;
+  ret = search(mdp_config, std::max(ivMaxSearchTime - coarse_time, 0.0),
+               &solution_state_ids, &path_cost);
+  // the corridor may be too narrow: widen it (and finally drop it) until a
+  // solution is found
+  while ((!ret || solution_state_ids.empty()) &&
+         ivPlannerEnvironmentPtr->hasCorridor())
   {
-    ROS_ERROR("Failed to set start state.");
-    return false;
-  }
-  if (ivPlannerPtr->set_goal(mdp_config.goalstateid) == 0)
-  {
-    ROS_ERROR("Failed to set goal state\n");
-    return false;
-  }
-
-  ivPlannerPtr->set_initialsolution_eps(ivInitialEpsilon);
-  ivPlannerPtr->set_search_mode(ivSearchUntilFirstSolution);
+    double remaining_time =
+        ivMaxSearchTime - (ros::WallTime::now() - startTime).toSec();
+    if (remaining_time <= 0.0)
+      break;
 
-  ROS_INFO("Start planning (max time: %f, initial eps: %f (%f))\n",
-           ivMaxSearchTime, ivInitialEpsilon,
-           ivPlannerPtr->get_initial_eps());
-  int path_cost;
-  ros::WallTime startTime = ros::WallTime::now();
-  try
-  {
-    ret = ivPlannerPtr->replan(ivMaxSearchTime, &solution_state_ids,
-                               &path_cost);
-  }
-  catch (const SBPL_Exception& e)
-  {
-    // ROS_ERROR("SBPL planning failed (%s)", e.what());
-    return false;
+    corridor_width *= 2.0;
+    if (corridor_width > ivMaxCorridorWidth)
+    {
+      ROS_INFO("No solution within the corridor, planning without "
+               "corridor.");
+      ivPlannerEnvironmentPtr->clearCorridor();
+    }
+    else
+    {
+      ROS_INFO("No solution within the corridor, widening it to %f m.",
+               corridor_width);
+      ivPlannerEnvironmentPtr->setCorridor(corridor_path, corridor_width);
+    }
+    ivPlannerEnvironmentPtr->resetSearch();
+    setPlanner();
+    solution_state_ids.clear();
+    ret = search(mdp_config, remaining_time, &solution_state_ids, &path_cost);
   }
   ivPathCost = double(path_cost) / FootstepPlannerEnvironment::cvMmScale;
 
@@ -368,21 +677,59 @@ FootstepPlanner::run()
     ROS_INFO("Solution of size %zu found after %f s",
              solution_state_ids.size(),
              (ros::WallTime::now()-startTime).toSec());
+    if (ivHierarchical)
+    {
+      ROS_INFO("Planning time: %f s coarse / %f s fine", coarse_time,
+               (ros::WallTime::now()-startTime).toSec() - coarse_time);
+    }
 
     if (extractPath(solution_state_ids))
     {
+      if (!pathIsCollisionFree())
+      {
+        ivPath.clear();
+        return false;
+      }
+
       ROS_INFO("Expanded states: %i total / %i new",
                ivPlannerEnvironmentPtr->getNumExpandedStates(),
                ivPlannerPtr->get_n_expands());
       ROS_INFO("Final eps: %f", ivPlannerPtr->get_final_epsilon());
       ROS_INFO("Path cost: %f (%i)\n", ivPathCost, path_cost);
 
+      const StateHashTable& hash_table =
+          ivPlannerEnvironmentPtr->getStateHashTable();
+      ROS_DEBUG("State hash table: %zu states in %zu slots (%u resizes), "
+                "%lu lookups, avg. probe length %f, max. probe length %u",
+                hash_table.size(), hash_table.capacity(),
+                hash_table.getNumResizes(), hash_table.getNumLookups(),
+                hash_table.getAvgProbeLength(),
+                hash_table.getMaxProbeLength());
+      const ChunkedArena<PlanningState>& state_arena =
+          ivPlannerEnvironmentPtr->getStateArena();
+      ROS_DEBUG("State arena: %zu states in %zu chunks (%zu chunk "
+                "allocations in total, %zu bytes)",
+                state_arena.getNumAllocations(), state_arena.getNumChunks(),
+                state_arena.getNumChunkAllocations(),
+                state_arena.getMemoryUsage() +
+                ivPlannerEnvironmentPtr->getIndexArena().getMemoryUsage());
+      boost::shared_ptr<const CollisionCache> collision_cache =
+          ivPlannerEnvironmentPtr->getCollisionCache();
+      if (collision_cache)
+      {
+        ROS_DEBUG("Collision cache: %lu lookups, hit rate %f (%zu bytes)",
+                  collision_cache->getNumLookups(),
+                  collision_cache->getHitRate(),
+                  collision_cache->getMemoryUsage());
+      }
+
       ivPlanningStatesIds = solution_state_ids;
 
       broadcastExpandedNodesVis();
       broadcastRandomNodesVis();
       broadcastFootstepPathVis();
       broadcastPathVis();
+      broadcastHeuristicPathVis();
 
       return true;
     }
@@ -460,6 +807,54 @@ FootstepPlanner::extractPath(const std::vector<int>& state_ids)
 }
 
 
+bool
+FootstepPlanner::pathIsCollisionFree()
+const
+{
+  // with lazy collision checks only the expanded states have been checked,
+  // so the path is validated once more
+  if (!ivEnvironmentParams.lazy_collision_check)
+    return true;
+
+  state_iter_t path_iter;
+  for (path_iter = ivPath.begin(); path_iter != ivPath.end(); ++path_iter)
+  {
+    if (ivPlannerEnvironmentPtr->occupied(*path_iter))
+    {
+      ROS_ERROR("Foot pose at (%f %f %f) of the path is colliding.",
+                path_iter->getX(), path_iter->getY(),
+                path_iter->getTheta());
+      return false;
+    }
+  }
+  return true;
+}
+
+
+void
+FootstepPlanner::streamSolution(const std::vector<int>& state_ids,
+                                int path_cost)
+{
+  if (!extractPath(state_ids) || !pathIsCollisionFree())
+    return;
+
+  ivPathCost = double(path_cost) / FootstepPlannerEnvironment::cvMmScale;
+  anytime_solution solution;
+  solution.cost = ivPathCost;
+  solution.eps = ivPlannerPtr->get_solution_eps();
+  solution.expanded_states = ivPlannerEnvironmentPtr->getNumExpandedStates();
+  solution.time = (ros::WallTime::now() - ivPlanningStartTime).toSec();
+  ROS_INFO("Solution of size %zu (cost %f, eps %f, %i expanded states) "
+           "found after %f s", ivPath.size(), solution.cost, solution.eps,
+           solution.expanded_states, solution.time);
+
+  broadcastFootstepPathVis();
+  broadcastPathVis();
+  if (ivSolutionCallback)
+    ivSolutionCallback(solution);
+}
+
+
 void
 FootstepPlanner::reset()
 {
@@ -476,6 +871,27 @@ FootstepPlanner::reset()
 }
 
 
+void
+FootstepPlanner::resetSearch()
+{
+  size_t memory = ivPlannerEnvironmentPtr->getMemoryUsage();
+  if (memory > size_t(ivWarmStartMaxMemory) * 1024 * 1024)
+  {
+    ROS_INFO("Planning states use %zu MB, resetting the environment.",
+             memory / (1024 * 1024));
+    reset();
+    return;
+  }
+
+  // reset the previously calculated paths
+  ivPath.clear();
+  ivPlanningStatesIds.clear();
+  // keep the planning states, only reset the search information
+  ivPlannerEnvironmentPtr->resetSearch();
+  setPlanner();
+}
+
+
 void
 FootstepPlanner::resetTotally()
 {
@@ -484,7 +900,7 @@ FootstepPlanner::resetTotally()
   ivPlanningStatesIds.clear();
   // reinitialize the planner environment
   ivPlannerEnvironmentPtr.reset(
-      new FootstepPlannerEnvironment(ivEnvironmentParams));
+      FootstepPlannerEnvironment::create(ivEnvironmentParams));
   setPlanner();
 }
 
@@ -504,10 +920,18 @@ FootstepPlanner::plan(bool force_new_plan)
     return false;
   }
 
-  if (force_new_plan
-      || ivPlannerType == "RSTARPlanner" || ivPlannerType == "ARAPlanner" )
+  // NOTE: the hierarchical planning and the heuristic corridor change the
+  // corridor of the search (which invalidates a previous search) and
+  // therefore always plan from scratch
+  if (force_new_plan || ivHierarchical || ivHeuristicCorridor
+      || ivPlannerType == "RSTARPlanner" || ivPlannerType == "ARAPlanner"
+      || ivPlannerType == "PASEPlanner"
+      || ivPlannerType == "BidirectionalPlanner")
   {
-    reset();
+    if (ivWarmStart)
+      resetSearch();
+    else
+      reset();
   }
   // start the planning and return success
   return run();
@@ -629,8 +1053,8 @@ FootstepPlanner::mapCallback(
   // new map: update the map information
   if (updateMap(map))
   {
-    // NOTE: update map currently simply resets the planner, i.e. replanning
-    // here is in fact a planning from the scratch
+    // NOTE: only the AD planner reuses the previous search (see
+    // updateEnvironment()), the other planners plan from scratch
     plan(false);
   }
 }
@@ -744,12 +1168,12 @@ FootstepPlanner::updateMap(const GridMap2DPtr map)
   ivMapPtr.reset();
   ivMapPtr = map;
 
+  if (ivCoarseEnvironmentPtr)
+    ivCoarseEnvironmentPtr->updateMap(map);
+
   // check if a previous map and a path existed
   if (old_map && (bool)ivPath.size())
-  {
-    updateEnvironment(old_map);
-    return true;
-  }
+    return updateEnvironment(old_map);
 
   // ..otherwise the environment's map can simply be updated
   ivPlannerEnvironmentPtr->updateMap(map);
@@ -757,119 +1181,144 @@ FootstepPlanner::updateMap(const GridMap2DPtr map)
 }
 
 
-void
+bool
 FootstepPlanner::updateEnvironment(const GridMap2DPtr old_map)
 {
-  ROS_INFO("Reseting the planning environment.");
-  // reset environment
-  resetTotally();
-  // set the new map
+  const nav_msgs::MapMetaData& old_info = old_map->getInfo();
+  const nav_msgs::MapMetaData& new_info = ivMapPtr->getInfo();
+  // NOTE: only the AD planner is able to reuse the previous search, this is
+  // only possible if the geometry of the maps is identical
+  if (ivPlannerType != "ADPlanner" ||
+      old_info.resolution != new_info.resolution ||
+      old_info.width != new_info.width ||
+      old_info.height != new_info.height ||
+      old_info.origin.position.x != new_info.origin.position.x ||
+      old_info.origin.position.y != new_info.origin.position.y)
+  {
+    ROS_INFO("Reseting the planning environment.");
+    // reset environment
+    resetTotally();
+    // set the new map
+    ivPlannerEnvironmentPtr->updateMap(ivMapPtr);
+    return true;
+  }
+
+  ROS_INFO("Received an updated map => change detection");
+
+  // to get all changed cells (new free and occupied) use XOR
+  cv::Mat changed_cells;
+  cv::bitwise_xor(old_map->binaryMap(), ivMapPtr->binaryMap(),
+                  changed_cells);
+  // inflate by the outer foot radius (invert for distanceTransform)
+  cv::bitwise_not(changed_cells, changed_cells);
+  cv::Mat changed_dist_map(changed_cells.size(), CV_32FC1);
+  cv::distanceTransform(changed_cells, changed_dist_map,
+                        CV_DIST_L2, CV_DIST_MASK_PRECISE);
+  double max_foot_radius = sqrt(
+      pow(std::abs(ivEnvironmentParams.foot_origin_shift_x) +
+          ivEnvironmentParams.footsize_x / 2.0, 2.0) +
+      pow(std::abs(ivEnvironmentParams.foot_origin_shift_y) +
+          ivEnvironmentParams.footsize_y / 2.0, 2.0)) /
+      ivMapPtr->getResolution();
+  // threshold, also invert back (changed cells are marked with 255)
+  changed_cells = (changed_dist_map <= max_foot_radius);
+
+  int num_changed_cells = cv::countNonZero(changed_cells);
+  if (num_changed_cells == 0)
+  {
+    // NOTE: the environment keeps the old (identical) map, so the cached
+    // collision checks and heuristic values stay valid
+    ROS_INFO("old map equals new map; no replanning necessary");
+    return false;
+  }
+
+  ROS_INFO("%d changed map cells found", num_changed_cells);
+  if (num_changed_cells > ivChangedCellsLimit)
+  {
+    ROS_INFO("Reset old information in new planning task");
+    // reset planner
+    reset();
+    ivPlannerEnvironmentPtr->updateMap(ivMapPtr);
+    return true;
+  }
+
+  // get all planning grid cells whose center lies within a changed map
+  // cell (NOTE: the cv::Mat of the binary map stores x as rows and y as
+  // columns)
+  double cell_size = ivEnvironmentParams.cell_size;
+  double resolution = ivMapPtr->getResolution();
+  double origin_x = new_info.origin.position.x;
+  double origin_y = new_info.origin.position.y;
+  std::vector<std::pair<int, int> > changed_planning_cells;
+  for (int mx = 0; mx < changed_cells.rows; ++mx)
+  {
+    const uchar* row = changed_cells.ptr<uchar>(mx);
+    for (int my = 0; my < changed_cells.cols; ++my)
+    {
+      if (row[my] == 0)
+        continue;
+      // the planning cell x contains the center (x + 0.5) * cell_size
+      int x_min = int(ceil((origin_x + mx * resolution) / cell_size - 0.5));
+      int x_max = int(ceil((origin_x + (mx + 1) * resolution) / cell_size -
+                           0.5));
+      int y_min = int(ceil((origin_y + my * resolution) / cell_size - 0.5));
+      int y_max = int(ceil((origin_y + (my + 1) * resolution) / cell_size -
+                           0.5));
+      for (int x = x_min; x < x_max; ++x)
+      {
+        for (int y = y_min; y < y_max; ++y)
+          changed_planning_cells.push_back(std::pair<int, int>(x, y));
+      }
+    }
+  }
+
+  // the new map has to be set before the planner is informed about the
+  // changes (invalidates cached collision checks and heuristic values)
   ivPlannerEnvironmentPtr->updateMap(ivMapPtr);
 
+  ROS_INFO("Use old information in new planning task");
+  std::vector<int> neighbour_ids;
+  if (ivEnvironmentParams.forward_search)
+    ivPlannerEnvironmentPtr->getSuccsOfGridCells(changed_planning_cells,
+                                                 &neighbour_ids);
+  else
+    ivPlannerEnvironmentPtr->getPredsOfGridCells(changed_planning_cells,
+                                                 &neighbour_ids);
+
+  boost::shared_ptr<ADPlanner> ad_planner =
+      boost::dynamic_pointer_cast<ADPlanner>(ivPlannerPtr);
+  ad_planner->costs_changed(PlanningStateChangeQuery(neighbour_ids));
+
+  return true;
+}
+
+
+bool
+FootstepPlanner::saveStepCostTable(const std::string& filename, double radius)
+{
+  StepCostTable table;
+  ivPlannerEnvironmentPtr->computeStepCostTable(radius, &table);
+  if (!table.save(filename))
+  {
+    ROS_ERROR("Could not write the step cost table to %s", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
 
-  // The following is not used any more
-
-  // Replanning based on old planning info currently disabled
-  //        // TODO: handle size changes of the map; currently the planning
-  //        // information is reseted
-  //
-  //        if (ivPlannerType == "ADPlanner" &&
-  //            ivMapPtr->getResolution() == old_map->getResolution() &&
-  //            ivMapPtr->size().height == old_map->size().height &&
-  //            ivMapPtr->size().width == old_map->size().width)
-  //        {
-  //            ROS_INFO("Received an updated map => change detection");
-  //
-  //            std::vector<State2> changed_states;
-  //            cv::Mat changed_cells;
-  //
-  //            // get new occupied cells only (0: occupied in binary map)
-  //            // changedCells(x,y) = old(x,y) AND NOT(new(x,y))
-  ////          cv::bitwise_not(gridMap->binaryMap(), changedCells);
-  ////          cv::bitwise_and(ivMapPtr->binaryMap(), changedCells, changedCells);
-  //
-  //            // to get all changed cells (new free and occupied) use XOR:
-  //            cv::bitwise_xor(old_map->binaryMap(), ivMapPtr->binaryMap(),
-  //                            changed_cells);
-  //
-  //            //inflate by outer foot radius:
-  //            cv::bitwise_not(changed_cells, changed_cells); // invert for distanceTransform
-  //            cv::Mat changedDistMap = cv::Mat(changed_cells.size(), CV_32FC1);
-  //            cv::distanceTransform(changed_cells, changedDistMap,
-  //                                  CV_DIST_L2, CV_DIST_MASK_PRECISE);
-  //            double max_foot_radius = sqrt(
-  //                    pow(std::abs(ivOriginFootShiftX) + ivFootsizeX / 2.0, 2.0) +
-  //                    pow(std::abs(ivOriginFootShiftY) + ivFootsizeY / 2.0, 2.0))
-  //                    / ivMapPtr->getResolution();
-  //            changed_cells = (changedDistMap <= max_foot_radius); // threshold, also invert back
-  //
-  //            // loop over changed cells (now marked with 255 in the mask):
-  //            unsigned int num_changed_cells = 0;
-  //            double wx, wy;
-  //            State2 s;
-  //            for (int y = 0; y < changed_cells.rows; ++y)
-  //            {
-  //                for (int x = 0; x < changed_cells.cols; ++x)
-  //                {
-  //                    if (changed_cells.at<uchar>(x,y) == 255)
-  //                    {
-  //                        ++num_changed_cells;
-  //                        ivMapPtr->mapToWorld(x, y, wx, wy);
-  //                        s.setX(wx);
-  //                        s.setY(wy);
-  //                        // on each grid cell ivNumAngleBins-many planning states
-  //                        // can be placed (if the resolution of the grid cells is
-  //                        // the same as of the planning state grid)
-  //                        for (int theta = 0; theta < ivNumAngleBins; ++theta)
-  //                        {
-  //                            s.setTheta(angle_cell_2_state(theta, ivNumAngleBins));
-  //                            changed_states.push_back(s);
-  //                        }
-  //                    }
-  //                }
-  //            }
-  //
-  //            if (num_changed_cells == 0)
-  //            {
-  //                ROS_INFO("old map equals new map; no replanning necessary");
-  //                return;
-  //            }
-  //
-  //            ROS_INFO("%d changed map cells found", num_changed_cells);
-  //            if (num_changed_cells <= ivChangedCellsLimit)
-  //            {
-  //                // update planer
-  //                ROS_INFO("Use old information in new planning taks");
-  //
-  //                std::vector<int> neighbour_ids;
-  //                if (ivForwardSearch)
-  //                    ivPlannerEnvironmentPtr->getSuccsOfGridCells(
-  //                            changed_states, &neighbour_ids);
-  //                else
-  //                    ivPlannerEnvironmentPtr->getPredsOfGridCells(
-  //                            changed_states, &neighbour_ids);
-  //
-  //                boost::shared_ptr<ADPlanner> h =
-  //                        boost::dynamic_pointer_cast<ADPlanner>(ivPlannerPtr);
-  //                h->costs_changed(PlanningStateChangeQuery(neighbour_ids));
-  //            }
-  //            else
-  //            {
-  //                ROS_INFO("Reset old information in new planning task");
-  //                // reset planner
-  //                ivPlannerEnvironmentPtr->reset();
-  //                setPlanner();
-  //                //ivPlannerPtr->force_planning_from_scratch();
-  //            }
-  //        }
-  //        else
-  //        {
-  //            ROS_INFO("Reset old information in new planning task");
-  //            // reset planner
-  //            ivPlannerEnvironmentPtr->reset();
-  //            setPlanner();
-  //            //ivPlannerPtr->force_planning_from_scratch();
-  //        }
+bool
+FootstepPlanner::getHeuristicPath(
+    std::vector<std::pair<double, double> >* path) const
+{
+  if (!ivPathCostHeuristicPtr)
+    return false;
+
+  // the 2D path costs are calculated towards the goal when planning forward
+  // and towards the start when planning backward
+  const State& from = ivEnvironmentParams.forward_search ? ivStartFootLeft :
+                                                            ivGoalFootLeft;
+  return ivPathCostHeuristicPtr->getPath(from.getX(), from.getY(), path);
 }
 
 
@@ -939,10 +1388,11 @@ FootstepPlanner::broadcastExpandedNodesVis()
     geometry_msgs::Point32 point;
     std::vector<geometry_msgs::Point32> points;
 
-    State s;
-    FootstepPlannerEnvironment::exp_states_2d_iter_t state_id_it;
-    for(state_id_it = ivPlannerEnvironmentPtr->getExpandedStatesStart();
-        state_id_it != ivPlannerEnvironmentPtr->getExpandedStatesEnd();
+    std::vector<std::pair<int, int> > expanded_states;
+    ivPlannerEnvironmentPtr->getExpandedStates(&expanded_states);
+    std::vector<std::pair<int, int> >::const_iterator state_id_it;
+    for(state_id_it = expanded_states.begin();
+        state_id_it != expanded_states.end();
         ++state_id_it)
     {
       point.x = cell_2_state(state_id_it->first,
@@ -1076,6 +1526,32 @@ FootstepPlanner::broadcastPathVis()
 }
 
 
+void
+FootstepPlanner::broadcastHeuristicPathVis()
+{
+  std::vector<std::pair<double, double> > path;
+  if (!getHeuristicPath(&path))
+    return;
+
+  nav_msgs::Path path_msg;
+  geometry_msgs::PoseStamped state;
+
+  state.header.stamp = ros::Time::now();
+  state.header.frame_id = ivMapPtr->getFrameID();
+
+  std::vector<std::pair<double, double> >::const_iterator path_iter;
+  for(path_iter = path.begin(); path_iter != path.end(); ++path_iter)
+  {
+    state.pose.position.x = path_iter->first;
+    state.pose.position.y = path_iter->second;
+    path_msg.poses.push_back(state);
+  }
+
+  path_msg.header = state.header;
+  ivHeuristicPathVisPub.publish(path_msg);
+}
+
+
 void
 FootstepPlanner::footPoseToMarker(const State& foot_pose,
                                   visualization_msgs::Marker* marker)
@@ -20,6 +20,13 @@
 
 #include <footstep_planner/FootstepPlannerEnvironment.h>
 
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <typeinfo>
+
 
 namespace footstep_planner
 {
@@ -31,8 +38,9 @@ FootstepPlannerEnvironment::FootstepPlannerEnvironment(
   ivIdStartFootRight(-1),
   ivIdGoalFootLeft(-1),
   ivIdGoalFootRight(-1),
-  ivpStateHash2State(
-    new std::vector<const PlanningState*>[params.hash_table_size]),
+  ivStateArena(cvArenaChunkSize),
+  ivIndexArena(cvArenaChunkSize * NUMOFINDICES_STATEID2IND),
+  ivStateHashTable(params.hash_table_size),
   ivFootstepSet(params.footstep_set),
   ivHeuristicConstPtr(params.heuristic),
   ivFootsizeX(params.footsize_x),
@@ -50,23 +58,95 @@ FootstepPlannerEnvironment::FootstepPlannerEnvironment(
                        params.num_angle_bins)),
   ivStepCost(cvMmScale * params.step_cost),
   ivCollisionCheckAccuracy(params.collision_check_accuracy),
+  ivCollisionShape(params.footsize_x, params.footsize_y,
+                   params.collision_check_accuracy),
   ivHashTableSize(params.hash_table_size),
   ivCellSize(params.cell_size),
   ivNumAngleBins(params.num_angle_bins),
   ivForwardSearch(params.forward_search),
   ivMaxStepWidth(double(disc_val(params.max_step_width, params.cell_size))),
+  ivMaxStepWidthSq(int64_t(ivMaxStepWidth) * int64_t(ivMaxStepWidth)),
   ivNumRandomNodes(params.num_random_nodes),
   ivRandomNodeDist(params.random_node_distance / ivCellSize),
   ivHeuristicScale(params.heuristic_scale),
+  ivMaxHeuristic(INFINITECOST / std::max(params.max_epsilon, 1.0)),
   ivHeuristicExpired(true),
-  ivNumExpandedStates(0)
+  ivCollisionLayersThreads(params.collision_layers_threads),
+  ivLazyCollisionCheck(params.lazy_collision_check),
+  ivMapCellMinX(0),
+  ivMapCellMinY(0),
+  ivMapCellMaxX(-1),
+  ivMapCellMaxY(-1),
+  ivTrackExpandedStates(false),
+  ivUseCorridor(false),
+  ivNumExpandedStates(0),
+  ivConcurrentExpansions(false),
+  ivFootSeparation(disc_val(params.foot_separation, params.cell_size))
 {
+  // the angle bins have to fit into the packed planning state key
+  assert(ivNumAngleBins <= (1 << STATE_KEY_THETA_BITS));
+
+  // resolve the PathCostHeuristic once (its distances are updated with the
+  // map and the goal)
+  ivPathCostHeuristicPtr =
+      boost::dynamic_pointer_cast<PathCostHeuristic>(ivHeuristicConstPtr);
+
   int num_angle_bins_half = ivNumAngleBins / 2;
   if (ivMaxFootstepTheta >= num_angle_bins_half)
     ivMaxFootstepTheta -= ivNumAngleBins;
   if (ivMaxInvFootstepTheta >= num_angle_bins_half)
     ivMaxInvFootstepTheta -= ivNumAngleBins;
 
+  // rotation of each angle bin (used by the collision checks)
+  ivAngleCos.resize(ivNumAngleBins);
+  ivAngleSin.resize(ivNumAngleBins);
+  for (int i = 0; i < ivNumAngleBins; ++i)
+  {
+    double theta = angle_cell_2_state(i, ivNumAngleBins);
+    ivAngleCos[i] = cos(theta);
+    ivAngleSin[i] = sin(theta);
+  }
+  ivAngleCosFixed.resize(ivNumAngleBins);
+  ivAngleSinFixed.resize(ivNumAngleBins);
+  for (int i = 0; i < ivNumAngleBins; ++i)
+  {
+    ivAngleCosFixed[i] = round(ivAngleCos[i] * (1 << cvRotationFixedBits));
+    ivAngleSinFixed[i] = round(ivAngleSin[i] * (1 << cvRotationFixedBits));
+  }
+
+  // the successors and predecessors of each orientation and leg (relative
+  // to the current state) and the costs to reach them
+  size_t num_footsteps = ivFootstepSet.size();
+  size_t num_neighbors = size_t(ivNumAngleBins) * 2 * num_footsteps;
+  ivSuccessorKeyDelta.resize(num_neighbors);
+  ivSuccessorCost.resize(num_neighbors);
+  ivPredecessorKeyDelta.resize(num_neighbors);
+  ivPredecessorCost.resize(num_neighbors);
+  ivNeighborKeys.resize(num_footsteps);
+  ivNeighborCosts.resize(num_footsteps);
+  ivNeighborCollisions.resize(num_footsteps);
+  for (int theta = 0; theta < ivNumAngleBins; ++theta)
+  {
+    for (int leg = RIGHT; leg <= LEFT; ++leg)
+    {
+      PlanningState origin(0, 0, theta, Leg(leg));
+      size_t row = neighborRow(origin);
+      for (size_t i = 0; i < num_footsteps; ++i)
+      {
+        PlanningState successor =
+            ivFootstepSet[i].performMeOnThisState(origin);
+        ivSuccessorKeyDelta[row + i] = successor.getKey() - origin.getKey();
+        ivSuccessorCost[row + i] = stepCost(origin, successor);
+
+        PlanningState predecessor =
+            ivFootstepSet[i].reverseMeOnThisState(origin);
+        ivPredecessorKeyDelta[row + i] =
+            predecessor.getKey() - origin.getKey();
+        ivPredecessorCost[row + i] = stepCost(origin, predecessor);
+      }
+    }
+  }
+
   int num_x = ivMaxFootstepX - ivMaxInvFootstepX + 1;
   ivpStepRange = new bool[num_x * (ivMaxFootstepY - ivMaxInvFootstepY + 1)];
 
@@ -80,17 +160,96 @@ FootstepPlannerEnvironment::FootstepPlannerEnvironment(
         pointWithinPolygon(i, j, params.step_range);
     }
   }
+
+  // the state area around the start (backward search) or goal (forward
+  // search) is made up of all (reachable) discrete steps within the step
+  // range: precompute the key deltas of these steps for each orientation
+  // and leg, 0 marks a step which is not reachable (a valid key delta
+  // always changes the leg)
+  ivNumStateAreaSteps = size_t(ivMaxFootstepTheta - ivMaxInvFootstepTheta + 1) *
+                        (ivMaxFootstepX - ivMaxInvFootstepX + 1) *
+                        (ivMaxFootstepY - ivMaxInvFootstepY + 1);
+  ivStateAreaKeyDelta.assign(
+      size_t(ivNumAngleBins) * 2 * ivNumStateAreaSteps, 0);
+  size_t step_index = 0;
+  for (int step_y = ivMaxInvFootstepY; step_y <= ivMaxFootstepY; ++step_y)
+  {
+    for (int step_x = ivMaxInvFootstepX; step_x <= ivMaxFootstepX; ++step_x)
+    {
+      for (int step_theta = ivMaxInvFootstepTheta;
+           step_theta <= ivMaxFootstepTheta;
+           ++step_theta, ++step_index)
+      {
+        Footstep step(cont_val(step_x, ivCellSize),
+                      cont_val(step_y, ivCellSize),
+                      angle_cell_2_state(step_theta, ivNumAngleBins),
+                      ivCellSize, ivNumAngleBins);
+        for (int theta = 0; theta < ivNumAngleBins; ++theta)
+        {
+          for (int leg = RIGHT; leg <= LEFT; ++leg)
+          {
+            PlanningState origin(0, 0, theta, Leg(leg));
+            bool valid;
+            PlanningState s(origin);
+            if (ivForwardSearch)
+            {
+              s = step.reverseMeOnThisState(origin);
+              valid = reachable(s, origin);
+            }
+            else
+            {
+              s = step.performMeOnThisState(origin);
+              valid = reachable(origin, s);
+            }
+            if (valid)
+            {
+              ivStateAreaKeyDelta[stateAreaRow(origin) + step_index] =
+                  s.getKey() - origin.getKey();
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (params.collision_layers)
+  {
+    ivCollisionLayersPtr.reset(new CollisionLayers(
+        ivFootsizeX, ivFootsizeY, ivOriginFootShiftX, ivOriginFootShiftY,
+        ivNumAngleBins,
+        size_t(params.collision_layers_max_memory) * 1024 * 1024));
+  }
+  if (params.collision_cache)
+  {
+    ivCollisionCachePtr.reset(new CollisionCache(ivCellSize,
+                                                 ivNumAngleBins));
+  }
+  if (params.collision_threads > 1)
+    ivCollisionCheckPoolPtr.reset(new WorkerPool(params.collision_threads));
+
+  if (!params.step_cost_table.empty())
+  {
+    ivStepCostTablePtr.reset(new StepCostTable());
+    if (!ivStepCostTablePtr->load(params.step_cost_table, ivNumAngleBins,
+                                  getLatticeSignature()))
+    {
+      ROS_ERROR("Could not read the step cost table %s or it was computed "
+                "for different footsteps, it is not used.",
+                params.step_cost_table.c_str());
+      ivStepCostTablePtr.reset();
+    }
+    else if (!ivForwardSearch)
+    {
+      ROS_WARN("The step cost table is only used for forward planning.");
+      ivStepCostTablePtr.reset();
+    }
+  }
 }
 
 
 FootstepPlannerEnvironment::~FootstepPlannerEnvironment()
 {
   reset();
-  if (ivpStateHash2State)
-  {
-    delete[] ivpStateHash2State;
-    ivpStateHash2State = NULL;
-  }
   if (ivpStepRange)
   {
     delete[] ivpStepRange;
@@ -99,6 +258,22 @@ FootstepPlannerEnvironment::~FootstepPlannerEnvironment()
 }
 
 
+FootstepPlannerEnvironment*
+FootstepPlannerEnvironment::create(const environment_params& params)
+{
+  // the specialized variants call the heuristic non-virtually, so they
+  // require its exact type
+  const std::type_info& heuristic_type = typeid(*params.heuristic);
+  if (heuristic_type == typeid(PathCostHeuristic))
+    return new FootstepPlannerEnvironmentT<PathCostHeuristic>(params);
+  if (heuristic_type == typeid(EuclStepCostHeuristic))
+    return new FootstepPlannerEnvironmentT<EuclStepCostHeuristic>(params);
+  if (heuristic_type == typeid(EuclideanHeuristic))
+    return new FootstepPlannerEnvironmentT<EuclideanHeuristic>(params);
+  return new FootstepPlannerEnvironment(params);
+}
+
+
 std::pair<int, int>
 FootstepPlannerEnvironment::updateGoal(const State& foot_left,
                                        const State& foot_right)
@@ -125,7 +300,7 @@ FootstepPlannerEnvironment::updateGoal(const State& foot_left,
   if (ivForwardSearch)
   {
     // check if the goal states have been changed
-    if (goal_foot_id_left != ivIdGoalFootLeft &&
+    if (goal_foot_id_left != ivIdGoalFootLeft ||
         goal_foot_id_right != ivIdGoalFootRight)
     {
       ivHeuristicExpired = true;
@@ -178,7 +353,7 @@ FootstepPlannerEnvironment::updateStart(const State& foot_left,
 const PlanningState*
 FootstepPlannerEnvironment::createNewHashEntry(const State& s)
 {
-  PlanningState tmp(s, ivCellSize, ivNumAngleBins, ivHashTableSize);
+  PlanningState tmp(s, ivCellSize, ivNumAngleBins);
   return createNewHashEntry(tmp);
 }
 
@@ -186,8 +361,7 @@ FootstepPlannerEnvironment::createNewHashEntry(const State& s)
 const PlanningState*
 FootstepPlannerEnvironment::createNewHashEntry(const PlanningState& s)
 {
-  unsigned int state_hash = s.getHashTag();
-  PlanningState* new_state = new PlanningState(s);
+  PlanningState* new_state = new (ivStateArena.allocate()) PlanningState(s);
 
   size_t state_id = ivStateId2State.size();
   assert(state_id < (size_t)std::numeric_limits<int>::max());
@@ -196,10 +370,10 @@ FootstepPlannerEnvironment::createNewHashEntry(const PlanningState& s)
   new_state->setId(state_id);
   ivStateId2State.push_back(new_state);
 
-  // insert the new state into the hash map at the corresponding position
-  ivpStateHash2State[state_hash].push_back(new_state);
+  // insert the ID of the new state into the hash map
+  ivStateHashTable.insert(s.getKey(), state_id);
 
-  int* entry = new int[NUMOFINDICES_STATEID2IND];
+  int* entry = ivIndexArena.allocate(NUMOFINDICES_STATEID2IND);
   StateID2IndexMapping.push_back(entry);
   for(int i = 0; i < NUMOFINDICES_STATEID2IND; ++i)
   {
@@ -215,7 +389,7 @@ FootstepPlannerEnvironment::createNewHashEntry(const PlanningState& s)
 const PlanningState*
 FootstepPlannerEnvironment::getHashEntry(const State& s)
 {
-  PlanningState tmp(s, ivCellSize, ivNumAngleBins, ivHashTableSize);
+  PlanningState tmp(s, ivCellSize, ivNumAngleBins);
   return getHashEntry(tmp);
 }
 
@@ -223,17 +397,11 @@ FootstepPlannerEnvironment::getHashEntry(const State& s)
 const PlanningState*
 FootstepPlannerEnvironment::getHashEntry(const PlanningState& s)
 {
-  unsigned int state_hash = s.getHashTag();
-  std::vector<const PlanningState*>::const_iterator state_iter;
-  for (state_iter = ivpStateHash2State[state_hash].begin();
-       state_iter != ivpStateHash2State[state_hash].end();
-       ++state_iter)
-  {
-    if (*(*state_iter) == s)
-      return *state_iter;
-  }
+  int state_id = ivStateHashTable.find(s.getKey());
+  if (state_id < 0)
+    return NULL;
 
-  return NULL;
+  return ivStateId2State[state_id];
 }
 
 const PlanningState*
@@ -249,6 +417,160 @@ FootstepPlannerEnvironment::createHashEntryIfNotExists(
 }
 
 
+void
+FootstepPlannerEnvironment::getNeighbors(const PlanningState& current,
+                                         const std::vector<uint64_t>& key_delta,
+                                         const std::vector<int>& step_cost,
+                                         std::vector<int>* NeighIDV,
+                                         std::vector<int>* CostV)
+{
+  getNeighbors(*ivHeuristicConstPtr, current, key_delta, step_cost, NeighIDV,
+               CostV);
+}
+
+
+template <class HeuristicT>
+void
+FootstepPlannerEnvironment::getNeighbors(const HeuristicT& heuristic,
+                                         const PlanningState& current,
+                                         const std::vector<uint64_t>& key_delta,
+                                         const std::vector<int>& step_cost,
+                                         std::vector<int>* NeighIDV,
+                                         std::vector<int>* CostV)
+{
+  const size_t num_footsteps = ivFootstepSet.size();
+  if (num_footsteps == 0)
+    return;
+  const size_t row = neighborRow(current);
+  const uint64_t* delta = &key_delta[row];
+  const uint64_t key = current.getKey();
+  uint64_t* keys = &ivNeighborKeys[0];
+  int* costs = &ivNeighborCosts[0];
+  unsigned char* collisions = &ivNeighborCollisions[0];
+  // concurrent expansions need their own scratch space
+  std::vector<uint64_t> local_keys;
+  std::vector<int> local_costs;
+  std::vector<unsigned char> local_collisions;
+  if (ivConcurrentExpansions)
+  {
+    local_keys.resize(num_footsteps);
+    local_costs.resize(num_footsteps);
+    local_collisions.resize(num_footsteps);
+    keys = &local_keys[0];
+    costs = &local_costs[0];
+    collisions = &local_collisions[0];
+  }
+
+  // all candidates at once (within the corridor, if any)
+  size_t num_candidates = 0;
+  for (size_t i = 0; i < num_footsteps; ++i)
+  {
+    const PlanningState candidate(key + delta[i]);
+    if (ivUseCorridor &&
+        !ivCorridor.test(candidate.getX(), candidate.getY()))
+    {
+      continue;
+    }
+    // neighbors checked lazily have to be on the map at least (otherwise
+    // they are dead ends anyway)
+    if (ivLazyCollisionCheck &&
+        (candidate.getX() < ivMapCellMinX ||
+         candidate.getX() > ivMapCellMaxX ||
+         candidate.getY() < ivMapCellMinY ||
+         candidate.getY() > ivMapCellMaxY))
+    {
+      continue;
+    }
+    keys[num_candidates] = candidate.getKey();
+    costs[num_candidates] = step_cost[row + i];
+    ++num_candidates;
+  }
+
+  // keep the candidates which are not colliding (unless checked lazily on
+  // expansion)
+  size_t num_free = num_candidates;
+  if (!ivLazyCollisionCheck)
+  {
+    checkCollisions(keys, num_candidates, collisions);
+    num_free = 0;
+    for (size_t i = 0; i < num_candidates; ++i)
+    {
+      if (collisions[i])
+        continue;
+      keys[num_free] = keys[i];
+      costs[num_free] = costs[i];
+      ++num_free;
+    }
+  }
+
+  // the state registry is shared by concurrent expansions
+  boost::unique_lock<boost::mutex> lock(ivStateRegistryMutex,
+                                        boost::defer_lock);
+  if (ivConcurrentExpansions)
+    lock.lock();
+
+  // start loading the hash table slots (and the heuristic's data) before
+  // they are accessed
+  for (size_t i = 0; i < num_free; ++i)
+  {
+    ivStateHashTable.prefetch(keys[i]);
+    heuristic.prefetch(PlanningState(keys[i]));
+  }
+
+  NeighIDV->reserve(NeighIDV->size() + num_free);
+  CostV->reserve(CostV->size() + num_free);
+  for (size_t i = 0; i < num_free; ++i)
+  {
+    const PlanningState* neighbor =
+        createHashEntryIfNotExists(PlanningState(keys[i]));
+    NeighIDV->push_back(neighbor->getId());
+    CostV->push_back(costs[i]);
+  }
+}
+
+
+void
+FootstepPlannerEnvironment::checkCollisions(const uint64_t* keys,
+                                            size_t num_keys,
+                                            unsigned char* collisions)
+{
+  // NOTE: the pool can only be used by one thread at a time
+  if (ivCollisionCheckPoolPtr && !ivConcurrentExpansions && num_keys > 1)
+  {
+    ivCollisionCheckPoolPtr->run(
+        num_keys, boost::bind(&FootstepPlannerEnvironment::checkCollision,
+                              this, keys, collisions, _1));
+    return;
+  }
+
+  for (size_t i = 0; i < num_keys; ++i)
+    collisions[i] = occupied(PlanningState(keys[i]));
+}
+
+
+void
+FootstepPlannerEnvironment::checkCollision(const uint64_t* keys,
+                                           unsigned char* collisions,
+                                           size_t i)
+{
+  collisions[i] = occupied(PlanningState(keys[i]));
+}
+
+
+void
+FootstepPlannerEnvironment::markExpanded(const PlanningState& s)
+{
+  boost::unique_lock<boost::mutex> lock(ivStateRegistryMutex,
+                                        boost::defer_lock);
+  if (ivConcurrentExpansions)
+    lock.lock();
+
+  if (ivTrackExpandedStates)
+    ivExpandedStates.set(s.getX(), s.getY());
+  ++ivNumExpandedStates;
+}
+
+
 int
 FootstepPlannerEnvironment::stepCost(const PlanningState& a,
                                      const PlanningState& b)
@@ -268,8 +590,7 @@ FootstepPlannerEnvironment::stepCost(const PlanningState& a,
 bool
 FootstepPlannerEnvironment::occupied(const State& s)
 {
-  return occupied(PlanningState(s, ivCellSize, ivNumAngleBins,
-                                ivHashTableSize));
+  return occupied(PlanningState(s, ivCellSize, ivNumAngleBins));
 }
 
 
@@ -278,23 +599,56 @@ FootstepPlannerEnvironment::occupied(const PlanningState& s)
 {
   double x = cell_2_state(s.getX(), ivCellSize);
   double y = cell_2_state(s.getY(), ivCellSize);
+  // look up the collision in the precomputed layers (if available)
+  bool collision;
+  if (ivCollisionLayersPtr &&
+      ivCollisionLayersPtr->lookup(x, y, s.getTheta(), s.getLeg(), &collision))
+  {
+    return collision;
+  }
+  // look up the result of a previous check of the same state
+  boost::unique_lock<boost::mutex> cache_lock(ivCollisionCacheMutex,
+                                              boost::defer_lock);
+  if (ivCollisionCachePtr)
+  {
+    if (concurrentCollisionChecks())
+      cache_lock.lock();
+    if (ivCollisionCachePtr->lookup(s, &collision))
+      return collision;
+    // the collision check itself runs unlocked
+    if (cache_lock.owns_lock())
+      cache_lock.unlock();
+  }
+
   // collision check for the planning state
   if (ivMapPtr->isOccupiedAt(x,y))
-    return true;
-  double theta = angle_cell_2_state(s.getTheta(), ivNumAngleBins);
-  double theta_cos = cos(theta);
-  double theta_sin = sin(theta);
-
-  // transform the planning state to the foot center
-  x += theta_cos*ivOriginFootShiftX - theta_sin*ivOriginFootShiftY;
-  if (s.getLeg() == LEFT)
-    y += theta_sin*ivOriginFootShiftX + theta_cos*ivOriginFootShiftY;
-  else // leg == RLEG
-    y += theta_sin*ivOriginFootShiftX - theta_cos*ivOriginFootShiftY;
+  {
+    collision = true;
+  }
+  else
+  {
+    double theta_cos = ivAngleCos[s.getTheta()];
+    double theta_sin = ivAngleSin[s.getTheta()];
+
+    // transform the planning state to the foot center
+    x += theta_cos*ivOriginFootShiftX - theta_sin*ivOriginFootShiftY;
+    if (s.getLeg() == LEFT)
+      y += theta_sin*ivOriginFootShiftX + theta_cos*ivOriginFootShiftY;
+    else // leg == RLEG
+      y += theta_sin*ivOriginFootShiftX - theta_cos*ivOriginFootShiftY;
+
+    // collision check for the foot center
+    collision = collision_check(x, y, theta_cos, theta_sin,
+                                ivCollisionShape, *ivMapPtr);
+  }
 
-  // collision check for the foot center
-  return collision_check(x, y, theta, ivFootsizeX, ivFootsizeY,
-                         ivCollisionCheckAccuracy, *ivMapPtr);
+  if (ivCollisionCachePtr)
+  {
+    if (concurrentCollisionChecks())
+      cache_lock.lock();
+    ivCollisionCachePtr->insert(s, collision);
+  }
+  return collision;
 }
 
 
@@ -321,18 +675,96 @@ FootstepPlannerEnvironment::updateMap(gridmap_2d::GridMap2DPtr map)
   ivMapPtr.reset();
   ivMapPtr = map;
 
-  if (ivHeuristicConstPtr->getHeuristicType() == Heuristic::PATH_COST)
+  if (ivCollisionLayersPtr)
+  {
+    ivCollisionLayersPtr->updateMap(map);
+    if (ivCollisionLayersThreads > 0)
+      ivCollisionLayersPtr->buildAll(ivCollisionLayersThreads);
+  }
+  if (ivCollisionCachePtr)
+    ivCollisionCachePtr->updateMap(map);
+
+  // the expanded states are tracked for all cells covered by the map
+  const nav_msgs::MapMetaData& info = map->getInfo();
+  int min_x = state_2_cell(info.origin.position.x, ivCellSize);
+  int min_y = state_2_cell(info.origin.position.y, ivCellSize);
+  int num_x =
+      state_2_cell(info.origin.position.x + info.width * info.resolution,
+                   ivCellSize) - min_x + 1;
+  int num_y =
+      state_2_cell(info.origin.position.y + info.height * info.resolution,
+                   ivCellSize) - min_y + 1;
+  ivExpandedStates.resize(min_x, min_y, num_x, num_y);
+  // ..as well as the corridor (which has to be set again)
+  ivCorridor.resize(min_x, min_y, num_x, num_y);
+  ivUseCorridor = false;
+  ivMapCellMinX = min_x;
+  ivMapCellMinY = min_y;
+  ivMapCellMaxX = min_x + num_x - 1;
+  ivMapCellMaxY = min_y + num_y - 1;
+  ivChangedCells.resize(min_x, min_y, num_x, num_y);
+
+  if (ivPathCostHeuristicPtr)
   {
-    boost::shared_ptr<PathCostHeuristic> h =
-        boost::dynamic_pointer_cast<PathCostHeuristic>(
-            ivHeuristicConstPtr);
-    h->updateMap(map);
+    ivPathCostHeuristicPtr->updateMap(map);
 
     ivHeuristicExpired = true;
   }
 }
 
 
+void
+FootstepPlannerEnvironment::setCorridor(
+    const std::vector<std::pair<double, double> >& path, double width)
+{
+  assert(ivMapPtr);
+
+  ivCorridor.clear();
+  ivUseCorridor = true;
+  if (path.empty())
+    return;
+
+  const double width_sq = width * width;
+  for (size_t i = 0; i < path.size(); ++i)
+  {
+    // the segment from the previous point to the current one (a single
+    // point for the first one)
+    const std::pair<double, double>& b = path[i];
+    const std::pair<double, double>& a = i > 0 ? path[i - 1] : b;
+    double seg_x = b.first - a.first;
+    double seg_y = b.second - a.second;
+    double seg_length_sq = seg_x * seg_x + seg_y * seg_y;
+
+    int x_min = state_2_cell(std::min(a.first, b.first) - width, ivCellSize);
+    int x_max = state_2_cell(std::max(a.first, b.first) + width, ivCellSize);
+    int y_min = state_2_cell(std::min(a.second, b.second) - width,
+                             ivCellSize);
+    int y_max = state_2_cell(std::max(a.second, b.second) + width,
+                             ivCellSize);
+    for (int x = x_min; x <= x_max; ++x)
+    {
+      double cx = cell_2_state(x, ivCellSize);
+      for (int y = y_min; y <= y_max; ++y)
+      {
+        double cy = cell_2_state(y, ivCellSize);
+        // project the cell's center onto the segment
+        double t = 0.0;
+        if (seg_length_sq > 0.0)
+        {
+          t = ((cx - a.first) * seg_x + (cy - a.second) * seg_y) /
+              seg_length_sq;
+          t = std::max(0.0, std::min(1.0, t));
+        }
+        double dx = a.first + t * seg_x - cx;
+        double dy = a.second + t * seg_y - cy;
+        if (dx * dx + dy * dy <= width_sq)
+          ivCorridor.set(x, y);
+      }
+    }
+  }
+}
+
+
 void
 FootstepPlannerEnvironment::updateHeuristicValues()
 {
@@ -345,11 +777,8 @@ FootstepPlannerEnvironment::updateHeuristicValues()
 
   ROS_INFO("Updating the heuristic values.");
 
-  if (ivHeuristicConstPtr->getHeuristicType() == Heuristic::PATH_COST)
+  if (ivPathCostHeuristicPtr)
   {
-    boost::shared_ptr<PathCostHeuristic> h =
-        boost::dynamic_pointer_cast<PathCostHeuristic>(
-            ivHeuristicConstPtr);
     MDPConfig MDPCfg;
     InitializeMDPCfg(&MDPCfg);
     const PlanningState* start = ivStateId2State[MDPCfg.startstateid];
@@ -358,9 +787,9 @@ FootstepPlannerEnvironment::updateHeuristicValues()
     // NOTE: start/goal state are set to left leg
     bool success;
     if (ivForwardSearch)
-      success = h->calculateDistances(*start, *goal);
+      success = ivPathCostHeuristicPtr->calculateDistances(*start, *goal);
     else
-      success = h->calculateDistances(*goal, *start);
+      success = ivPathCostHeuristicPtr->calculateDistances(*goal, *start);
     if (!success)
     {
       ROS_ERROR("Failed to calculate path cost heuristic.");
@@ -376,22 +805,20 @@ FootstepPlannerEnvironment::updateHeuristicValues()
 void
 FootstepPlannerEnvironment::reset()
 {
-  for(unsigned int i = 0; i < ivStateId2State.size(); ++i)
-  {
-    if (ivStateId2State[i])
-    {
-      delete ivStateId2State[i];
-    }
-  }
+  // the planning states and index rows are owned by the arenas and freed
+  // all at once (the chunks are kept for the next planning task)
   ivStateId2State.clear();
 
-  if (ivpStateHash2State)
-  {
-    for(int i = 0; i < ivHashTableSize; ++i)
-      ivpStateHash2State[i].clear();
-  }
+  ivStateHashTable.clear();
+  ivStateHashTable.resetStatistics();
+
+  // the cached collision checks stay valid as long as the map is unchanged
+  if (ivCollisionCachePtr)
+    ivCollisionCachePtr->resetStatistics();
 
   StateID2IndexMapping.clear();
+  ivStateArena.clear();
+  ivIndexArena.clear();
 
   ivExpandedStates.clear();
   ivNumExpandedStates = 0;
@@ -408,6 +835,43 @@ FootstepPlannerEnvironment::reset()
 }
 
 
+void
+FootstepPlannerEnvironment::resetSearch()
+{
+  // the new SBPL planner has to create its own search states
+  std::vector<int*>::iterator index_iter;
+  for (index_iter = StateID2IndexMapping.begin();
+       index_iter != StateID2IndexMapping.end();
+       ++index_iter)
+  {
+    std::fill(*index_iter, *index_iter + NUMOFINDICES_STATEID2IND, -1);
+  }
+
+  ivStateHashTable.resetStatistics();
+  if (ivCollisionCachePtr)
+    ivCollisionCachePtr->resetStatistics();
+
+  ivExpandedStates.clear();
+  ivNumExpandedStates = 0;
+  ivRandomStates.clear();
+}
+
+
+size_t
+FootstepPlannerEnvironment::getMemoryUsage()
+const
+{
+  // NOTE: reset() keeps the reserved storage, so only the storage in use is
+  // counted (otherwise the usage would never drop below the limit again)
+  return ivStateArena.getNumAllocations() * sizeof(PlanningState) +
+         ivIndexArena.getNumAllocations() * NUMOFINDICES_STATEID2IND *
+             sizeof(int) +
+         ivStateHashTable.getUsedMemory() +
+         ivStateId2State.size() * sizeof(const PlanningState*) +
+         StateID2IndexMapping.size() * sizeof(int*);
+}
+
+
 bool
 FootstepPlannerEnvironment::closeToStart(const PlanningState& from)
 {
@@ -441,28 +905,6 @@ bool
 FootstepPlannerEnvironment::reachable(const PlanningState& from,
                                       const PlanningState& to)
 {
-  if (euclidean_distance(from.getX(), from.getY(), to.getX(), to.getY()) >
-      ivMaxStepWidth)
-  {
-      return false;
-  }
-
-  tf::Transform step =
-    tf::Pose(
-      tf::createQuaternionFromYaw(
-        angle_cell_2_state(from.getTheta(), ivNumAngleBins)),
-      tf::Point(cell_2_state(from.getX(), ivCellSize),
-                cell_2_state(from.getY(), ivCellSize),
-                0.0)).inverse() *
-    tf::Pose(
-      tf::createQuaternionFromYaw(
-        angle_cell_2_state(from.getTheta(), ivNumAngleBins)),
-      tf::Point(cell_2_state(to.getX(), ivCellSize),
-                cell_2_state(to.getY(), ivCellSize),
-                0.0));
-  int footstep_x = disc_val(step.getOrigin().x(), ivCellSize);
-  int footstep_y = disc_val(step.getOrigin().y(), ivCellSize);
-
   // calculate the footstep rotation
   int footstep_theta = to.getTheta() - from.getTheta();
   // transform the value into [-ivNumAngleBins/2..ivNumAngleBins/2)
@@ -471,13 +913,32 @@ FootstepPlannerEnvironment::reachable(const PlanningState& from,
     footstep_theta -= ivNumAngleBins;
   else if (footstep_theta < -num_angle_bins_half)
     footstep_theta += ivNumAngleBins;
+  // adjust for the left foot
+  if (from.getLeg() == LEFT)
+    footstep_theta = -footstep_theta;
+
+  // fast pre-reject: check if footstep_theta is not within the executable
+  // range or the translation is too far
+  if (footstep_theta > ivMaxFootstepTheta ||
+      footstep_theta < ivMaxInvFootstepTheta)
+      return false;
+  int64_t dx = to.getX() - from.getX();
+  int64_t dy = to.getY() - from.getY();
+  if (dx*dx + dy*dy > ivMaxStepWidthSq)
+    return false;
 
+  // rotate the translation into the view of 'from' (fixed point arithmetic,
+  // rounded to the nearest cell like disc_val())
+  int64_t theta_cos = ivAngleCosFixed[from.getTheta()];
+  int64_t theta_sin = ivAngleSinFixed[from.getTheta()];
+  const int64_t half = int64_t(1) << (cvRotationFixedBits - 1);
+  int footstep_x =
+      int((theta_cos*dx + theta_sin*dy + half) >> cvRotationFixedBits);
+  int footstep_y =
+      int((theta_cos*dy - theta_sin*dx + half) >> cvRotationFixedBits);
   // adjust for the left foot
   if (from.getLeg() == LEFT)
-  {
     footstep_y = -footstep_y;
-    footstep_theta = -footstep_theta;
-  }
 
   // check if footstep_x is not within the executable range
   if (footstep_x > ivMaxFootstepX || footstep_x < ivMaxInvFootstepX)
@@ -485,111 +946,94 @@ FootstepPlannerEnvironment::reachable(const PlanningState& from,
   // check if footstep_y is not within the executable range
   if (footstep_y > ivMaxFootstepY || footstep_y < ivMaxInvFootstepY)
       return false;
-  // check if footstep_theta is not within the executable range
-  if (footstep_theta > ivMaxFootstepTheta ||
-      footstep_theta < ivMaxInvFootstepTheta)
-      return false;
   return ivpStepRange[(footstep_y - ivMaxInvFootstepY) *
                       (ivMaxFootstepX - ivMaxInvFootstepX + 1) +
                       (footstep_x - ivMaxInvFootstepX)];
+}
+
+
+int
+FootstepPlannerEnvironment::getStepCost(int FromStateID, int ToStateID)
+{
+  assert(FromStateID >= 0 && (unsigned int) FromStateID < ivStateId2State.size());
+  assert(ToStateID >= 0 && (unsigned int) ToStateID < ivStateId2State.size());
+
+  const PlanningState* from = ivStateId2State[FromStateID];
+  const PlanningState* to = ivStateId2State[ToStateID];
+  // each footstep changes the leg
+  if (from->getLeg() == to->getLeg() || !reachable(*from, *to))
+    return -1;
+  return stepCost(*from, *to);
+}
+
 
-//  // get the (continuous) orientation of state 'from'
-//  double orient = -(angle_cell_2_state(from.getTheta(), ivNumAngleBins));
-//  double orient_cos = cos(orient);
-//  double orient_sin = sin(orient);
-//
-//  // calculate the footstep shift and rotate it into the 'from'-view
-//  int footstep_x = to.getX() - from.getX();
-//  int footstep_y = to.getY() - from.getY();
-//  double shift_x = footstep_x * orient_cos - footstep_y * orient_sin;
-//  double shift_y = footstep_x * orient_sin + footstep_y * orient_cos;
-//  footstep_x = round(shift_x);
-//  footstep_y = round(shift_y);
-//
-//  // calculate the footstep rotation
-//  int footstep_theta = to.getTheta() - from.getTheta();
-//
-//  // transform the value into [-ivNumAngleBins/2..ivNumAngleBins/2)
-//  int num_angle_bins_half = ivNumAngleBins / 2;
-//  if (footstep_theta >= num_angle_bins_half)
-//    footstep_theta -= ivNumAngleBins;
-//  else if (footstep_theta < -num_angle_bins_half)
-//    footstep_theta += ivNumAngleBins;
-//
-//  // adjust for the left foot
-//  if (from.getLeg() == LEFT)
-//  {
-//    footstep_y = -footstep_y;
-//    footstep_theta = -footstep_theta;
-//  }
-//
-//  return (footstep_x <= ivMaxFootstepX &&
-//          footstep_x >= ivMaxInvFootstepX &&
-//          footstep_y <= ivMaxFootstepY &&
-//          footstep_y >= ivMaxInvFootstepY &&
-//          footstep_theta <= ivMaxFootstepTheta &&
-//          footstep_theta >= ivMaxInvFootstepTheta);
+int
+FootstepPlannerEnvironment::getStepCostLowerBound(double from_x,
+                                                  double from_y,
+                                                  double to_x,
+                                                  double to_y)
+const
+{
+  // the step costs are at least the step's length (in mm), only the
+  // transitions to the start or between the goal feet are shifted by up to
+  // the foot separation
+  double dist = sqrt((to_x - from_x) * (to_x - from_x) +
+                     (to_y - from_y) * (to_y - from_y));
+  return int(std::max(dist - getFootSeparation(), 0.0) * cvMmScale);
 }
 
 
 void
 FootstepPlannerEnvironment::getPredsOfGridCells(
-    const std::vector<State>& changed_states,
+    const std::vector<std::pair<int, int> >& changed_cells,
     std::vector<int>* pred_ids)
 {
-  pred_ids->clear();
-
-  std::vector<State>::const_iterator state_iter;
-  for (state_iter = changed_states.begin();
-      state_iter != changed_states.end();
-      ++state_iter)
-  {
-    PlanningState s(*state_iter, ivCellSize, ivNumAngleBins,
-                    ivHashTableSize);
-    // generate predecessor planning states
-    std::vector<Footstep>::const_iterator footstep_set_iter;
-    for(footstep_set_iter = ivFootstepSet.begin();
-        footstep_set_iter != ivFootstepSet.end();
-        ++footstep_set_iter)
-    {
-      PlanningState pred = footstep_set_iter->reverseMeOnThisState(s);
-      // check if predecessor exists
-      const PlanningState* pred_hash_entry = getHashEntry(pred);
-      if (pred_hash_entry == NULL)
-        continue;
-      pred_ids->push_back(pred_hash_entry->getId());
-    }
-  }
+  // the predecessors reach a changed cell with one of their successors
+  getStatesOfGridCells(changed_cells, ivSuccessorKeyDelta, pred_ids);
 }
 
 
 void
 FootstepPlannerEnvironment::getSuccsOfGridCells(
-    const std::vector<State>& changed_states,
+    const std::vector<std::pair<int, int> >& changed_cells,
     std::vector<int>* succ_ids)
 {
-  succ_ids->clear();
+  getStatesOfGridCells(changed_cells, ivPredecessorKeyDelta, succ_ids);
+}
 
-  std::vector<State>::const_iterator state_iter;
-  for (state_iter = changed_states.begin();
-      state_iter != changed_states.end();
-      ++state_iter)
+
+void
+FootstepPlannerEnvironment::getStatesOfGridCells(
+    const std::vector<std::pair<int, int> >& changed_cells,
+    const std::vector<uint64_t>& key_delta,
+    std::vector<int>* state_ids)
+{
+  state_ids->clear();
+
+  ivChangedCells.clear();
+  std::vector<std::pair<int, int> >::const_iterator cell_iter;
+  for (cell_iter = changed_cells.begin();
+       cell_iter != changed_cells.end();
+       ++cell_iter)
+  {
+    ivChangedCells.set(cell_iter->first, cell_iter->second);
+  }
+
+  // collect the states placed on a changed cell or one footstep away from
+  // one
+  const size_t num_footsteps = ivFootstepSet.size();
+  for (size_t id = 0; id < ivStateId2State.size(); ++id)
   {
-    PlanningState s(*state_iter, ivCellSize, ivNumAngleBins,
-                    ivHashTableSize);
-    // generate successors
-    std::vector<Footstep>::const_iterator footstep_set_iter;
-    for(footstep_set_iter = ivFootstepSet.begin();
-        footstep_set_iter != ivFootstepSet.end();
-        ++footstep_set_iter)
+    const PlanningState& s = *ivStateId2State[id];
+    bool changed = ivChangedCells.test(s.getX(), s.getY());
+    const uint64_t* delta = &key_delta[neighborRow(s)];
+    for (size_t i = 0; i < num_footsteps && !changed; ++i)
     {
-      PlanningState succ = footstep_set_iter->performMeOnThisState(s);
-      // check if successor exists
-      const PlanningState* succ_hash_entry = getHashEntry(succ);
-      if (succ_hash_entry == NULL)
-        continue;
-      succ_ids->push_back(succ_hash_entry->getId());
+      const PlanningState neighbor(s.getKey() + delta[i]);
+      changed = ivChangedCells.test(neighbor.getX(), neighbor.getY());
     }
+    if (changed)
+      state_ids->push_back(id);
   }
 }
 
@@ -597,6 +1041,24 @@ FootstepPlannerEnvironment::getSuccsOfGridCells(
 int
 FootstepPlannerEnvironment::GetFromToHeuristic(int FromStateID,
                                                int ToStateID)
+{
+  return getFromToHeuristic(*ivHeuristicConstPtr, FromStateID, ToStateID);
+}
+
+
+int
+FootstepPlannerEnvironment::GetFromToHeuristic(const PlanningState& from,
+                                               const PlanningState& to)
+{
+  return getFromToHeuristic(*ivHeuristicConstPtr, from, to);
+}
+
+
+template <class HeuristicT>
+int
+FootstepPlannerEnvironment::getFromToHeuristic(const HeuristicT& heuristic,
+                                               int FromStateID,
+                                               int ToStateID)
 {
   assert(FromStateID >= 0 && (unsigned int) FromStateID < ivStateId2State.size());
   assert(ToStateID >= 0 && (unsigned int) ToStateID < ivStateId2State.size());
@@ -608,26 +1070,283 @@ FootstepPlannerEnvironment::GetFromToHeuristic(int FromStateID,
 
   const PlanningState* from = ivStateId2State[FromStateID];
   const PlanningState* to = ivStateId2State[ToStateID];
-  //    	if (ivHeuristicConstPtr->getHeuristicType() == Heuristic::PATH_COST){
-  //    		boost::shared_ptr<PathCostHeuristic> pathCostHeuristic = boost::dynamic_pointer_cast<PathCostHeuristic>(ivHeuristicConstPtr);
-  //    		pathCostHeuristic->calculateDistances(*from, *to);
-  //    	}
-  return GetFromToHeuristic(*from, *to);
+  return getFromToHeuristic(heuristic, *from, *to);
 }
 
+
+template <class HeuristicT>
 int
-FootstepPlannerEnvironment::GetFromToHeuristic(const PlanningState& from,
+FootstepPlannerEnvironment::getFromToHeuristic(const HeuristicT& heuristic,
+                                               const PlanningState& from,
                                                const PlanningState& to)
 {
-  return cvMmScale * ivHeuristicScale *
-    ivHeuristicConstPtr->getHValue(from, to);
+  // e.g. unreachable cells of the PathCostHeuristic
+  return std::min(cvMmScale * ivHeuristicScale *
+                  getHValue(heuristic, from, to), ivMaxHeuristic);
 }
 
 
 int
 FootstepPlannerEnvironment::GetGoalHeuristic(int stateID)
 {
-  return GetFromToHeuristic(stateID, ivIdGoalFootLeft);
+  return getGoalHeuristic(*ivHeuristicConstPtr, stateID);
+}
+
+
+template <class HeuristicT>
+int
+FootstepPlannerEnvironment::getGoalHeuristic(const HeuristicT& heuristic,
+                                             int stateID)
+{
+  int h = getFromToHeuristic(heuristic, stateID, ivIdGoalFootLeft);
+  if (ivStepCostTablePtr)
+  {
+    // near the goal the costs of the footstep lattice are a tighter bound
+    // (the maximum of two consistent heuristics is consistent)
+    int step_costs = getStepCostTableHeuristic(
+        *ivStateId2State[stateID], *ivStateId2State[ivIdGoalFootLeft]);
+    if (step_costs >= 0)
+      h = std::max(h, int(ivHeuristicScale * step_costs));
+  }
+  return h;
+}
+
+
+int
+FootstepPlannerEnvironment::getStepCostTableHeuristic(
+    const PlanningState& from, const PlanningState& goal)
+const
+{
+  // the table is computed for each goal orientation, so the relative
+  // position is looked up without rotation
+  return ivStepCostTablePtr->lookup(goal.getTheta(),
+                                    from.getX() - goal.getX(),
+                                    from.getY() - goal.getY(),
+                                    from.getTheta(), from.getLeg());
+}
+
+
+uint64_t
+FootstepPlannerEnvironment::getLatticeSignature()
+const
+{
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  std::vector<int64_t> values;
+  values.push_back(ivNumAngleBins);
+  values.push_back(int64_t(ivCellSize * 1e6));
+  values.push_back(ivFootSeparation);
+  values.push_back(ivMaxFootstepX);
+  values.push_back(ivMaxFootstepY);
+  values.push_back(ivMaxFootstepTheta);
+  values.push_back(ivMaxInvFootstepX);
+  values.push_back(ivMaxInvFootstepY);
+  values.push_back(ivMaxInvFootstepTheta);
+  values.insert(values.end(), ivSuccessorKeyDelta.begin(),
+                ivSuccessorKeyDelta.end());
+  values.insert(values.end(), ivSuccessorCost.begin(), ivSuccessorCost.end());
+  size_t num_steps = size_t(ivMaxFootstepX - ivMaxInvFootstepX + 1) *
+                     (ivMaxFootstepY - ivMaxInvFootstepY + 1);
+  values.insert(values.end(), ivpStepRange, ivpStepRange + num_steps);
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    for (int byte = 0; byte < 8; ++byte)
+    {
+      hash ^= (uint64_t(values[i]) >> (8 * byte)) & 0xFF;
+      hash *= 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+
+void
+FootstepPlannerEnvironment::computeStepCostTable(double radius,
+                                                 StepCostTable* table)
+{
+  ros::WallTime start_time = ros::WallTime::now();
+
+  int table_radius = disc_val(radius, ivCellSize);
+  int search_radius = 2 * table_radius;
+
+  // the longest footstep (in cells), including the steps onto the goal
+  double max_step = ivMaxStepWidth;
+  for (size_t i = 0; i < ivSuccessorKeyDelta.size(); ++i)
+  {
+    PlanningState step(PlanningState(0, 0, 0, RIGHT).getKey() +
+                       ivSuccessorKeyDelta[i]);
+    max_step = std::max(max_step, euclidean_distance(0, 0, step.getX(),
+                                                     step.getY()));
+  }
+  // a footstep of length d (in cells) costs at least slope * d (see
+  // stepCost(), the truncation to mm is covered by one mm of the step cost)
+  double slope = cvMmScale * ivCellSize +
+                 std::max(ivStepCost - 1, 0) / std::max(max_step, 1.0);
+
+  table->resize(table_radius, ivNumAngleBins, getLatticeSignature());
+  std::vector<int> costs;
+  for (int goal_theta = 0; goal_theta < ivNumAngleBins; ++goal_theta)
+  {
+    computeStepCosts(goal_theta, search_radius, &costs);
+
+    for (int x = -table_radius; x <= table_radius; ++x)
+    {
+      for (int y = -table_radius; y <= table_radius; ++y)
+      {
+        // the costs are capped by slope * (distance to the border of the
+        // table): the cap drops by at most the costs of a footstep, so the
+        // table stays consistent where it ends (0 outside of it); it also
+        // bounds the costs of paths leaving the searched area
+        double border_distance =
+            table_radius - euclidean_distance(0, 0, x, y);
+        int max_cost = std::max(int(floor(slope * border_distance)), 0);
+        for (int leg = RIGHT; leg <= LEFT; ++leg)
+        {
+          for (int theta = 0; theta < ivNumAngleBins; ++theta)
+          {
+            PlanningState s(x, y, theta, Leg(leg));
+            table->set(goal_theta, x, y, theta, Leg(leg),
+                       std::min(costs[stepCostIndex(s, search_radius)],
+                                max_cost));
+          }
+        }
+      }
+    }
+  }
+
+  ROS_INFO("Computed the step cost table (radius %d cells) in %f s.",
+           table_radius, (ros::WallTime::now() - start_time).toSec());
+}
+
+
+void
+FootstepPlannerEnvironment::computeStepCosts(int goal_theta,
+                                             int search_radius,
+                                             std::vector<int>* costs)
+{
+  int width = 2 * search_radius + 1;
+  costs->assign(2 * size_t(ivNumAngleBins) * width * width,
+                std::numeric_limits<int>::max());
+
+  // the goal's left foot is placed at the origin, the right foot beside it;
+  // both feet are discretized independently, so the right foot may be off
+  // by one cell in each direction: all these positions are goals
+  std::vector<PlanningState> goals;
+  goals.push_back(PlanningState(0, 0, goal_theta, LEFT));
+  int right_x = round(ivFootSeparation * ivAngleSin[goal_theta]);
+  int right_y = round(-ivFootSeparation * ivAngleCos[goal_theta]);
+  for (int dx = -1; dx <= 1; ++dx)
+  {
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+      goals.push_back(
+          PlanningState(right_x + dx, right_y + dy, goal_theta, RIGHT));
+    }
+  }
+
+  // the states from which each goal can be reached directly (see
+  // closeToGoal()); NOTE: unlike in the search they keep their other
+  // successors, i.e. each transition of the search is also one of this
+  // search (the costs stay a lower bound and consistent)
+  int max_step = int(ceil(ivMaxStepWidth));
+  std::vector<std::vector<uint64_t> > close_to_goal(goals.size());
+  for (size_t i = 0; i < goals.size(); ++i)
+  {
+    const PlanningState& goal = goals[i];
+    Leg leg = goal.getLeg() == LEFT ? RIGHT : LEFT;
+    for (int x = goal.getX() - max_step; x <= goal.getX() + max_step; ++x)
+    {
+      for (int y = goal.getY() - max_step; y <= goal.getY() + max_step; ++y)
+      {
+        for (int theta = 0; theta < ivNumAngleBins; ++theta)
+        {
+          PlanningState s(x, y, theta, leg);
+          if (reachable(s, goal))
+            close_to_goal[i].push_back(s.getKey());
+        }
+      }
+    }
+  }
+
+  // the footsteps leading to each orientation and leg (key delta and
+  // costs), i.e. the inverted successor table: the costs are exact for the
+  // lattice searched by GetSuccs()
+  std::vector<std::vector<std::pair<uint64_t, int> > > steps_to(
+      2 * ivNumAngleBins);
+  for (int theta = 0; theta < ivNumAngleBins; ++theta)
+  {
+    for (int leg = RIGHT; leg <= LEFT; ++leg)
+    {
+      PlanningState origin(0, 0, theta, Leg(leg));
+      size_t row = neighborRow(origin);
+      for (size_t i = 0; i < ivFootstepSet.size(); ++i)
+      {
+        PlanningState succ(origin.getKey() + ivSuccessorKeyDelta[row + i]);
+        steps_to[succ.getTheta() * 2 + (succ.getLeg() == LEFT)].push_back(
+            std::make_pair(ivSuccessorKeyDelta[row + i],
+                           ivSuccessorCost[row + i]));
+      }
+    }
+  }
+
+  // Dijkstra search backwards from the goals
+  typedef std::pair<int, uint64_t> queue_entry_t;
+  std::priority_queue<queue_entry_t, std::vector<queue_entry_t>,
+                      std::greater<queue_entry_t> > queue;
+  std::vector<PlanningState>::const_iterator goal_iter;
+  for (goal_iter = goals.begin(); goal_iter != goals.end(); ++goal_iter)
+  {
+    (*costs)[stepCostIndex(*goal_iter, search_radius)] = 0;
+    queue.push(queue_entry_t(0, goal_iter->getKey()));
+  }
+  std::vector<uint64_t> preds;
+  std::vector<int> pred_costs;
+  while (!queue.empty())
+  {
+    int cost = queue.top().first;
+    PlanningState s(queue.top().second);
+    queue.pop();
+    if (cost > (*costs)[stepCostIndex(s, search_radius)])
+      continue;
+
+    preds.clear();
+    pred_costs.clear();
+    goal_iter = std::find(goals.begin(), goals.end(), s);
+    if (goal_iter != goals.end())
+    {
+      const std::vector<uint64_t>& close =
+          close_to_goal[goal_iter - goals.begin()];
+      for (size_t i = 0; i < close.size(); ++i)
+      {
+        preds.push_back(close[i]);
+        pred_costs.push_back(stepCost(PlanningState(close[i]), s));
+      }
+    }
+    const std::vector<std::pair<uint64_t, int> >& steps =
+        steps_to[s.getTheta() * 2 + (s.getLeg() == LEFT)];
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+      preds.push_back(s.getKey() - steps[i].first);
+      pred_costs.push_back(steps[i].second);
+    }
+
+    for (size_t i = 0; i < preds.size(); ++i)
+    {
+      PlanningState pred(preds[i]);
+      if (std::abs(pred.getX()) > search_radius ||
+          std::abs(pred.getY()) > search_radius)
+      {
+        continue;
+      }
+      int pred_cost = cost + pred_costs[i];
+      int& costs_pred = (*costs)[stepCostIndex(pred, search_radius)];
+      if (pred_cost < costs_pred)
+      {
+        costs_pred = pred_cost;
+        queue.push(queue_entry_t(pred_cost, preds[i]));
+      }
+    }
+  }
 }
 
 
@@ -679,8 +1398,11 @@ FootstepPlannerEnvironment::GetPreds(int TargetStateID,
     }
   }
 
-  ivExpandedStates.insert(std::pair<int,int>(current->getX(), current->getY()));
-  ++ivNumExpandedStates;
+  markExpanded(*current);
+
+  // lazy collision checks: a colliding state is a dead end of the search
+  if (ivLazyCollisionCheck && occupied(*current))
+    return;
 
   if (closeToStart(*current))
   {
@@ -697,32 +1419,15 @@ FootstepPlannerEnvironment::GetPreds(int TargetStateID,
     return;
   }
 
-  PredIDV->reserve(ivFootstepSet.size());
-  CostV->reserve(ivFootstepSet.size());
-  std::vector<Footstep>::const_iterator footstep_set_iter;
-  for(footstep_set_iter = ivFootstepSet.begin();
-      footstep_set_iter != ivFootstepSet.end();
-      ++footstep_set_iter)
-  {
-    const PlanningState predecessor =
-        footstep_set_iter->reverseMeOnThisState(*current);
-    if (occupied(predecessor))
-      continue;
-
-    const PlanningState* predecessor_hash = createHashEntryIfNotExists(
-        predecessor);
-
-    int cost = stepCost(*current, *predecessor_hash);
-    PredIDV->push_back(predecessor_hash->getId());
-    CostV->push_back(cost);
-  }
+  getNeighbors(*current, ivPredecessorKeyDelta, ivPredecessorCost, PredIDV,
+               CostV);
 }
 
 
 int
 FootstepPlannerEnvironment::GetStartHeuristic(int stateID)
 {
-  return GetFromToHeuristic(stateID, ivIdStartFootLeft);
+  return getFromToHeuristic(*ivHeuristicConstPtr, stateID, ivIdStartFootLeft);
 }
 
 
@@ -777,8 +1482,11 @@ FootstepPlannerEnvironment::GetSuccs(int SourceStateID,
     }
   }
 
-  ivExpandedStates.insert(std::pair<int,int>(current->getX(), current->getY()));
-  ++ivNumExpandedStates;
+  markExpanded(*current);
+
+  // lazy collision checks: a colliding state is a dead end of the search
+  if (ivLazyCollisionCheck && occupied(*current))
+    return;
 
   if (closeToGoal(*current))
   {
@@ -796,25 +1504,8 @@ FootstepPlannerEnvironment::GetSuccs(int SourceStateID,
     return;
   }
 
-  SuccIDV->reserve(ivFootstepSet.size());
-  CostV->reserve(ivFootstepSet.size());
-  std::vector<Footstep>::const_iterator footstep_set_iter;
-  for(footstep_set_iter = ivFootstepSet.begin();
-      footstep_set_iter != ivFootstepSet.end();
-      ++footstep_set_iter)
-  {
-    PlanningState successor =
-        footstep_set_iter->performMeOnThisState(*current);
-    if (occupied(successor))
-      continue;
-
-    const PlanningState* successor_hash_entry =
-        createHashEntryIfNotExists(successor);
-
-    int cost = stepCost(*current, *successor_hash_entry);
-    SuccIDV->push_back(successor_hash_entry->getId());
-    CostV->push_back(cost);
-  }
+  getNeighbors(*current, ivSuccessorKeyDelta, ivSuccessorCost, SuccIDV,
+               CostV);
 }
 
 void
@@ -836,8 +1527,11 @@ FootstepPlannerEnvironment::GetSuccsTo(int SourceStateID, int goalStateId,
   }
 
   const PlanningState* current = ivStateId2State[SourceStateID];
-  ivExpandedStates.insert(std::pair<int,int>(current->getX(), current->getY()));
-  ++ivNumExpandedStates;
+  markExpanded(*current);
+
+  // lazy collision checks: a colliding state is a dead end of the search
+  if (ivLazyCollisionCheck && occupied(*current))
+    return;
 
   //ROS_INFO("GetSuccsTo %d -> %d: %f", SourceStateID, goalStateId, euclidean_distance(current->getX(), current->getY(), ivStateId2State[goalStateId]->getX(), ivStateId2State[goalStateId]->getY()));
 
@@ -879,24 +1573,8 @@ FootstepPlannerEnvironment::GetSuccsTo(int SourceStateID, int goalStateId,
   }
 
 
-  SuccIDV->reserve(ivFootstepSet.size());
-  CostV->reserve(ivFootstepSet.size());
-  std::vector<Footstep>::const_iterator footstep_set_iter;
-  for(footstep_set_iter = ivFootstepSet.begin();
-      footstep_set_iter != ivFootstepSet.end();
-      ++footstep_set_iter)
-  {
-    PlanningState successor =
-        footstep_set_iter->performMeOnThisState(*current);
-    if (occupied(successor))
-      continue;
-
-    const PlanningState* successor_hash = createHashEntryIfNotExists(successor);
-
-    int cost = stepCost(*current, *successor_hash);
-    SuccIDV->push_back(successor_hash->getId());
-    CostV->push_back(cost);
-  }
+  getNeighbors(*current, ivSuccessorKeyDelta, ivSuccessorCost, SuccIDV,
+               CostV);
 }
 
 
@@ -1036,7 +1714,7 @@ void FootstepPlannerEnvironment::GetRandomNeighs(const PlanningState* currentSta
     // random left/right
     Leg newLeg = Leg(rand() % 2);
 
-    PlanningState randomState(newX, newY, newTheta, newLeg, ivHashTableSize);
+    PlanningState randomState(newX, newY, newTheta, newLeg);
 
     // add both left and right if available:
     //    		int sep = disc_val(0.07, ivCellSize);
@@ -1237,50 +1915,54 @@ FootstepPlannerEnvironment::setStateArea(const PlanningState& left,
   const PlanningState* p_state = getHashEntry(right);
   ivStateArea.push_back(p_state->getId());
 
-  double cont_step_x, cont_step_y, cont_step_theta;
-  for (int step_y = ivMaxInvFootstepY; step_y <= ivMaxFootstepY; ++step_y)
+  const uint64_t* left_delta = &ivStateAreaKeyDelta[stateAreaRow(left)];
+  const uint64_t* right_delta = &ivStateAreaKeyDelta[stateAreaRow(right)];
+
+  // with a collision check pool, the candidates are checked at once
+  // beforehand (in the order in which the loop below consumes the results)
+  bool batch = ivCollisionCheckPoolPtr && !ivConcurrentExpansions;
+  std::vector<uint64_t> keys;
+  std::vector<unsigned char> collisions;
+  if (batch)
   {
-    for (int step_x = ivMaxInvFootstepX; step_x <= ivMaxFootstepX; ++step_x)
+    keys.reserve(2 * ivNumStateAreaSteps);
+    for (size_t i = 0; i < ivNumStateAreaSteps; ++i)
     {
-      for (int step_theta = ivMaxInvFootstepTheta;
-           step_theta <= ivMaxFootstepTheta;
-           ++step_theta)
-      {
-        cont_step_x = cont_val(step_x, ivCellSize);
-        cont_step_y = cont_val(step_y, ivCellSize);
-        cont_step_theta = angle_cell_2_state(step_theta, ivNumAngleBins);
-        Footstep step(cont_step_x, cont_step_y, cont_step_theta,
-                      ivCellSize, ivNumAngleBins, ivHashTableSize);
-        if (ivForwardSearch)
-        {
-          PlanningState pred = step.reverseMeOnThisState(left);
-          if (occupied(pred) || !reachable(pred, left))
-            continue;
-          p_state = createHashEntryIfNotExists(pred);
-          ivStateArea.push_back(p_state->getId());
-
-          pred = step.reverseMeOnThisState(right);
-          if (occupied(pred) || !reachable(pred, right))
-            continue;
-          p_state = createHashEntryIfNotExists(pred);
-          ivStateArea.push_back(p_state->getId());
-        }
-        else
-        {
-          PlanningState succ = step.performMeOnThisState(left);
-          if (occupied(succ) || !reachable(left, succ))
-            continue;
-          p_state = createHashEntryIfNotExists(succ);
-          ivStateArea.push_back(p_state->getId());
-
-          succ = step.performMeOnThisState(right);
-          if (occupied(succ) || !reachable(right, succ))
-            continue;
-          p_state = createHashEntryIfNotExists(succ);
-          ivStateArea.push_back(p_state->getId());
-        }
-      }
+      if (left_delta[i] == 0)
+        continue;
+      keys.push_back(left.getKey() + left_delta[i]);
+      if (right_delta[i] != 0)
+        keys.push_back(right.getKey() + right_delta[i]);
     }
+    collisions.resize(keys.size());
+    if (!keys.empty())
+      checkCollisions(&keys[0], keys.size(), &collisions[0]);
+  }
+
+  size_t next_check = 0;
+  for (size_t i = 0; i < ivNumStateAreaSteps; ++i)
+  {
+    // NOTE: predecessors for forward search, successors for backward search
+    if (left_delta[i] == 0)
+      continue;
+    PlanningState s(left.getKey() + left_delta[i]);
+    if (batch ? collisions[next_check++] : occupied(s))
+    {
+      // skip the result of the right foot as well
+      if (batch && right_delta[i] != 0)
+        ++next_check;
+      continue;
+    }
+    p_state = createHashEntryIfNotExists(s);
+    ivStateArea.push_back(p_state->getId());
+
+    if (right_delta[i] == 0)
+      continue;
+    s = PlanningState(right.getKey() + right_delta[i]);
+    if (batch ? collisions[next_check++] : occupied(s))
+      continue;
+    p_state = createHashEntryIfNotExists(s);
+    ivStateArea.push_back(p_state->getId());
   }
 }
 
@@ -1297,5 +1979,72 @@ const
   else
     return false;
 }
+
+
+template <class HeuristicT>
+FootstepPlannerEnvironmentT<HeuristicT>::FootstepPlannerEnvironmentT(
+    const environment_params& params)
+: FootstepPlannerEnvironment(params),
+  ivHeuristic(static_cast<const HeuristicT&>(*params.heuristic))
+{
+  assert(typeid(*params.heuristic) == typeid(HeuristicT));
+}
+
+
+template <class HeuristicT>
+FootstepPlannerEnvironmentT<HeuristicT>::~FootstepPlannerEnvironmentT()
+{}
+
+
+template <class HeuristicT>
+int
+FootstepPlannerEnvironmentT<HeuristicT>::GetFromToHeuristic(int FromStateID,
+                                                            int ToStateID)
+{
+  return getFromToHeuristic(ivHeuristic, FromStateID, ToStateID);
+}
+
+
+template <class HeuristicT>
+int
+FootstepPlannerEnvironmentT<HeuristicT>::GetGoalHeuristic(int stateID)
+{
+  return getGoalHeuristic(ivHeuristic, stateID);
+}
+
+
+template <class HeuristicT>
+int
+FootstepPlannerEnvironmentT<HeuristicT>::GetStartHeuristic(int stateID)
+{
+  return getFromToHeuristic(ivHeuristic, stateID, ivIdStartFootLeft);
+}
+
+
+template <class HeuristicT>
+int
+FootstepPlannerEnvironmentT<HeuristicT>::GetFromToHeuristic(
+    const PlanningState& from, const PlanningState& to)
+{
+  return getFromToHeuristic(ivHeuristic, from, to);
+}
+
+
+template <class HeuristicT>
+void
+FootstepPlannerEnvironmentT<HeuristicT>::getNeighbors(
+    const PlanningState& current, const std::vector<uint64_t>& key_delta,
+    const std::vector<int>& step_cost, std::vector<int>* NeighIDV,
+    std::vector<int>* CostV)
+{
+  FootstepPlannerEnvironment::getNeighbors(ivHeuristic, current, key_delta,
+                                           step_cost, NeighIDV, CostV);
+}
+
+
+// the variants selected by FootstepPlannerEnvironment::create()
+template class FootstepPlannerEnvironmentT<EuclideanHeuristic>;
+template class FootstepPlannerEnvironmentT<EuclStepCostHeuristic>;
+template class FootstepPlannerEnvironmentT<PathCostHeuristic>;
 }
 
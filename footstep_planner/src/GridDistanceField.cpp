@@ -0,0 +1,225 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/GridDistanceField.h>
+
+#include <ros/ros.h>
+#include <sbpl/headers.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <math.h>
+
+
+namespace footstep_planner
+{
+GridDistanceField::GridDistanceField(int num_threads)
+: ivNumThreads(std::max(num_threads, 1)),
+  ivWidth(0),
+  ivHeight(0),
+  ivStride(0),
+  ivBucketWidth(1),
+  ivNumBuckets(2)
+{}
+
+
+GridDistanceField::~GridDistanceField()
+{}
+
+
+void
+GridDistanceField::updateGrid(const unsigned char* grid, int width,
+                              int height,
+                              unsigned char obstacle_threshold,
+                              double resolution)
+{
+  ivWidth = width;
+  ivHeight = height;
+  ivStride = height + 2;
+
+  int n = 0;
+  for (int dx = -1; dx <= 1; ++dx)
+  {
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+      if (dx == 0 && dy == 0)
+        continue;
+      ivNeighborOffset[n] = dx * ivStride + dy;
+      // same as the transition costs of the SBPL2DGridSearch
+      ivNeighborCost[n] = std::max(
+          int(1000 * resolution * sqrt(double(dx*dx + dy*dy))), 1);
+      ++n;
+    }
+  }
+  ivBucketWidth = *std::min_element(ivNeighborCost, ivNeighborCost + 8);
+  int max_cost = *std::max_element(ivNeighborCost, ivNeighborCost + 8);
+  ivNumBuckets = 2 + (max_cost - 1) / ivBucketWidth;
+
+  // cells of the border are not traversable
+  std::vector<char> free(size_t(width + 2) * ivStride, 0);
+  for (int x = 0; x < width; ++x)
+  {
+    for (int y = 0; y < height; ++y)
+      free[index(x, y)] = grid[size_t(x) * height + y] < obstacle_threshold;
+  }
+
+  ivTransitions.assign(free.size(), 0);
+  for (int x = 0; x < width; ++x)
+  {
+    for (int y = 0; y < height; ++y)
+    {
+      int i = index(x, y);
+      if (!free[i])
+        continue;
+      n = 0;
+      for (int dx = -1; dx <= 1; ++dx)
+      {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+          if (dx == 0 && dy == 0)
+            continue;
+          // as for the 8-connected SBPL2DGridSearch, only the target cell
+          // of a diagonal transition has to be free
+          if (free[i + ivNeighborOffset[n]])
+          {
+            ivTransitions[i] |= 1 << n;
+          }
+          ++n;
+        }
+      }
+    }
+  }
+
+  ivDistances.assign(free.size(), INFINITECOST);
+}
+
+
+void
+GridDistanceField::compute(int goal_x, int goal_y)
+{
+  ros::WallTime start_time = ros::WallTime::now();
+
+  std::fill(ivDistances.begin(), ivDistances.end(), INFINITECOST);
+  if (goal_x < 0 || goal_x >= ivWidth || goal_y < 0 || goal_y >= ivHeight)
+  {
+    ROS_ERROR("Goal cell (%d, %d) of the distance field out of bounds",
+              goal_x, goal_y);
+    return;
+  }
+  ivDistances[index(goal_x, goal_y)] = 0;
+
+  std::vector<bucket_t> buckets(ivNumBuckets, bucket_t(ivNumThreads));
+  buckets[0][0].push_back(index(goal_x, goal_y));
+
+  boost::barrier barrier(ivNumThreads);
+  boost::thread_group threads;
+  for (int i = 1; i < ivNumThreads; ++i)
+  {
+    threads.create_thread(boost::bind(&GridDistanceField::expandBuckets,
+                                      this, i, &barrier, &buckets));
+  }
+  expandBuckets(0, &barrier, &buckets);
+  threads.join_all();
+
+  ROS_DEBUG("Distance field (%d x %d cells) computed in %f s.", ivWidth,
+            ivHeight, (ros::WallTime::now() - start_time).toSec());
+}
+
+
+void
+GridDistanceField::getDistances(std::vector<int>* distances) const
+{
+  distances->resize(size_t(ivWidth) * ivHeight);
+  for (int x = 0; x < ivWidth; ++x)
+  {
+    std::copy(ivDistances.begin() + index(x, 0),
+              ivDistances.begin() + index(x, 0) + ivHeight,
+              distances->begin() + size_t(x) * ivHeight);
+  }
+}
+
+
+void
+GridDistanceField::expandBuckets(int thread, boost::barrier* barrier,
+                                 std::vector<bucket_t>* buckets)
+{
+  int* distances = &ivDistances[0];
+  const unsigned char* transitions = &ivTransitions[0];
+
+  for (int k = 0; ; ++k)
+  {
+    // expand this thread's share of every list of the bucket k; all cells
+    // reached are inserted into (this thread's list of) a later bucket
+    const bucket_t& bucket = (*buckets)[k % ivNumBuckets];
+    for (int t = 0; t < ivNumThreads; ++t)
+    {
+      const std::vector<int>& cells = bucket[t];
+      size_t begin = cells.size() * thread / ivNumThreads;
+      size_t end = cells.size() * (thread + 1) / ivNumThreads;
+      for (size_t c = begin; c < end; ++c)
+      {
+        int i = cells[c];
+        int dist = distances[i];
+        // the cell was reached with lower costs before (and is expanded)
+        if (dist / ivBucketWidth != k)
+          continue;
+
+        unsigned char mask = transitions[i];
+        for (int n = 0; n < 8; ++n)
+        {
+          if (!(mask & (1 << n)))
+            continue;
+          int j = i + ivNeighborOffset[n];
+          int new_dist = dist + ivNeighborCost[n];
+          int old_dist = distances[j];
+          while (new_dist < old_dist)
+          {
+            if (__sync_bool_compare_and_swap(&distances[j], old_dist,
+                                             new_dist))
+            {
+              (*buckets)[(new_dist / ivBucketWidth) % ivNumBuckets][thread]
+                  .push_back(j);
+              break;
+            }
+            old_dist = distances[j];
+          }
+        }
+      }
+    }
+    barrier->wait();
+
+    // the bucket k is not accessed by the other threads any more
+    (*buckets)[k % ivNumBuckets][thread].clear();
+    bool done = true;
+    for (int b = 1; b < ivNumBuckets && done; ++b)
+    {
+      const bucket_t& next = (*buckets)[(k + b) % ivNumBuckets];
+      for (int t = 0; t < ivNumThreads && done; ++t)
+        done = next[t].empty();
+    }
+    // all threads have to see the same buckets to agree on 'done'
+    barrier->wait();
+    if (done)
+      return;
+  }
+}
+}
@@ -43,22 +43,6 @@ EuclideanHeuristic::~EuclideanHeuristic()
 {}
 
 
-double
-EuclideanHeuristic::getHValue(const PlanningState& from,
-                              const PlanningState& to)
-const
-{
-  if (from == to)
-    return 0.0;
-
-  // distance in cell size
-  double dist = euclidean_distance(from.getX(), from.getY(),
-                                   to.getX(), to.getY());
-  // return distance in meter
-  return cont_val(dist, ivCellSize);
-}
-
-
 EuclStepCostHeuristic::EuclStepCostHeuristic(double cell_size,
                                              int    num_angle_bins,
                                              double step_cost,
@@ -73,33 +57,4 @@ EuclStepCostHeuristic::EuclStepCostHeuristic(double cell_size,
 
 EuclStepCostHeuristic::~EuclStepCostHeuristic()
 {}
-
-
-double
-EuclStepCostHeuristic::getHValue(const PlanningState& from,
-                                 const PlanningState& to)
-const
-{
-  if (from == to)
-    return 0.0;
-
-  // distance in meter
-  double dist = cont_val(euclidean_distance(
-      from.getX(), from.getY(), to.getX(), to.getY()), ivCellSize);
-  double expected_steps = dist / ivMaxStepWidth;
-  double diff_angle = 0.0;
-  if (ivDiffAngleCost > 0.0)
-  {
-    // get the number of bins between from.theta and to.theta
-    int diff_angle_disc = (
-        ((to.getTheta() - from.getTheta()) % ivNumAngleBins) +
-        ivNumAngleBins) % ivNumAngleBins;
-    // get the rotation independent from the rotation direction
-    diff_angle = std::abs(angles::normalize_angle(
-        angle_cell_2_state(diff_angle_disc, ivNumAngleBins)));
-  }
-
-  return (dist + expected_steps * ivStepCost +
-      diff_angle * ivDiffAngleCost);
-}
 }
@@ -0,0 +1,311 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <footstep_planner/PASEPlanner.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <math.h>
+
+
+namespace footstep_planner
+{
+PASEPlanner::PASEPlanner(FootstepPlannerEnvironment* environment,
+                         bool forward_search, int num_threads,
+                         double independence_eps)
+: ivEnvironment(environment),
+  ivForwardSearch(forward_search),
+  ivNumThreads(std::max(num_threads, 1)),
+  ivIndependenceEps(std::max(independence_eps, 1.0)),
+  ivEps(1.0),
+  ivStartId(-1),
+  ivGoalId(-1),
+  ivMaxSelectionDepth(2 * ivNumThreads),
+  ivNumExpands(0),
+  ivTargetId(-1),
+  ivDone(false),
+  ivFound(false)
+{
+  ivEnvironment->setConcurrentExpansions(true);
+}
+
+
+PASEPlanner::~PASEPlanner()
+{}
+
+
+int
+PASEPlanner::replan(double allocated_time_sec,
+                    std::vector<int>* solution_stateIDs_V)
+{
+  int solcost;
+  return replan(allocated_time_sec, solution_stateIDs_V, &solcost);
+}
+
+
+int
+PASEPlanner::replan(double allocated_time_sec,
+                    std::vector<int>* solution_stateIDs_V, int* solcost)
+{
+  solution_stateIDs_V->clear();
+  if (ivStartId < 0 || ivGoalId < 0)
+    return 0;
+
+  ivSearchStates.clear();
+  ivOpen.clear();
+  ivBeingExpanded.clear();
+  ivNumExpands = 0;
+  ivDone = false;
+  ivFound = false;
+  ivDeadline = ros::WallTime::now() + ros::WallDuration(allocated_time_sec);
+
+  int source_id = ivForwardSearch ? ivStartId : ivGoalId;
+  ivTargetId = ivForwardSearch ? ivGoalId : ivStartId;
+  SearchState& source = getSearchState(source_id);
+  source.g = 0;
+  source.f = int(ivEps * source.h);
+  source.list = OPEN;
+  ivOpen.insert(std::make_pair(source.f, source_id));
+
+  boost::thread_group threads;
+  for (int i = 1; i < ivNumThreads; ++i)
+    threads.create_thread(boost::bind(&PASEPlanner::expandStates, this));
+  expandStates();
+  threads.join_all();
+
+  if (!ivFound)
+    return 0;
+
+  // follow the parents from the target to the source
+  std::vector<int> path;
+  for (int id = ivTargetId; id != -1; id = ivSearchStates[id].parent)
+    path.push_back(id);
+  // the solution is always ordered from the start to the goal
+  if (ivForwardSearch)
+    solution_stateIDs_V->assign(path.rbegin(), path.rend());
+  else
+    solution_stateIDs_V->assign(path.begin(), path.end());
+  *solcost = ivSearchStates[ivTargetId].g;
+
+  return 1;
+}
+
+
+void
+PASEPlanner::expandStates()
+{
+  std::vector<int> neighbor_ids;
+  std::vector<int> costs;
+
+  boost::unique_lock<boost::mutex> lock(ivMutex);
+  while (!ivDone)
+  {
+    if (ros::WallTime::now() > ivDeadline)
+    {
+      ivDone = true;
+      break;
+    }
+
+    int id = selectState();
+    if (id < 0)
+    {
+      // no solution exists
+      if (ivOpen.empty() && ivBeingExpanded.empty())
+      {
+        ivDone = true;
+        break;
+      }
+      // wait until an expansion has been finished (or the time is up)
+      ivExpansionFinished.timed_wait(lock, boost::posix_time::milliseconds(10));
+      continue;
+    }
+    if (id == ivTargetId)
+    {
+      ivFound = true;
+      ivDone = true;
+      break;
+    }
+
+    ivSearchStates[id].list = BEING_EXPANDED;
+    ivBeingExpanded.push_back(id);
+    ++ivNumExpands;
+    int g = ivSearchStates[id].g;
+
+    // the expansion (and thereby the collision checks) runs in parallel
+    lock.unlock();
+    if (ivForwardSearch)
+      ivEnvironment->GetSuccs(id, &neighbor_ids, &costs);
+    else
+      ivEnvironment->GetPreds(id, &neighbor_ids, &costs);
+    lock.lock();
+
+    for (size_t i = 0; i < neighbor_ids.size(); ++i)
+    {
+      int neighbor_id = neighbor_ids[i];
+      SearchState& neighbor = getSearchState(neighbor_id);
+      // states are not reopened (their g-values are within the bound)
+      if (neighbor.list == BEING_EXPANDED || neighbor.list == CLOSED)
+        continue;
+      int new_g = g + costs[i];
+      if (new_g >= neighbor.g)
+        continue;
+
+      if (neighbor.list == OPEN)
+        ivOpen.erase(std::make_pair(neighbor.f, neighbor_id));
+      neighbor.g = new_g;
+      neighbor.f = new_g + int(ivEps * neighbor.h);
+      neighbor.parent = id;
+      neighbor.list = OPEN;
+      ivOpen.insert(std::make_pair(neighbor.f, neighbor_id));
+    }
+
+    ivBeingExpanded.erase(std::find(ivBeingExpanded.begin(),
+                                    ivBeingExpanded.end(), id));
+    ivSearchStates[id].list = CLOSED;
+    ivExpansionFinished.notify_all();
+  }
+  ivExpansionFinished.notify_all();
+}
+
+
+int
+PASEPlanner::selectState()
+{
+  size_t depth = 0;
+  for (open_t::iterator candidate = ivOpen.begin();
+       candidate != ivOpen.end() && depth < ivMaxSelectionDepth;
+       ++candidate, ++depth)
+  {
+    const SearchState& s = ivSearchStates[candidate->second];
+
+    bool is_independent = true;
+    std::vector<int>::const_iterator expanded_iter;
+    for (expanded_iter = ivBeingExpanded.begin();
+         is_independent && expanded_iter != ivBeingExpanded.end();
+         ++expanded_iter)
+    {
+      is_independent = independent(s, ivSearchStates[*expanded_iter]);
+    }
+    for (open_t::const_iterator open_iter = ivOpen.begin();
+         is_independent && open_iter != candidate;
+         ++open_iter)
+    {
+      is_independent = independent(s, ivSearchStates[open_iter->second]);
+    }
+
+    if (is_independent)
+    {
+      int id = candidate->second;
+      ivOpen.erase(candidate);
+      return id;
+    }
+  }
+  return -1;
+}
+
+
+bool
+PASEPlanner::independent(const SearchState& s, const SearchState& other)
+const
+{
+  if (s.g <= other.g)
+    return true;
+
+  int lower_bound =
+      ivEnvironment->getStepCostLowerBound(other.x, other.y, s.x, s.y);
+  return s.g - other.g <= ivIndependenceEps * lower_bound;
+}
+
+
+PASEPlanner::SearchState&
+PASEPlanner::getSearchState(int id)
+{
+  if (size_t(id) >= ivSearchStates.size())
+    ivSearchStates.resize(id + 1);
+
+  SearchState& s = ivSearchStates[id];
+  if (s.h < 0)
+  {
+    s.h = ivForwardSearch ? ivEnvironment->GetGoalHeuristic(id) :
+                            ivEnvironment->GetStartHeuristic(id);
+    State state;
+    ivEnvironment->getState(id, &state);
+    s.x = state.getX();
+    s.y = state.getY();
+  }
+  return s;
+}
+
+
+int
+PASEPlanner::set_goal(int goal_stateID)
+{
+  ivGoalId = goal_stateID;
+  return 1;
+}
+
+
+int
+PASEPlanner::set_start(int start_stateID)
+{
+  ivStartId = start_stateID;
+  return 1;
+}
+
+
+int
+PASEPlanner::force_planning_from_scratch()
+{
+  // each search starts from scratch
+  return 1;
+}
+
+
+int
+PASEPlanner::set_search_mode(bool bSearchUntilFirstSolution)
+{
+  // the search always stops at the first solution
+  return 1;
+}
+
+
+void
+PASEPlanner::costs_changed(const StateChangeQuery& stateChange)
+{
+  // nothing to do, each search starts from scratch
+}
+
+
+double
+PASEPlanner::get_solution_eps() const
+{
+  return ivEps * ivIndependenceEps;
+}
+
+
+void
+PASEPlanner::set_initialsolution_eps(double initialsolution_eps)
+{
+  ivEps = std::max(initialsolution_eps, 1.0);
+}
+}
@@ -28,103 +28,213 @@ PathCostHeuristic::PathCostHeuristic(double cell_size,
                                      double step_cost,
                                      double diff_angle_cost,
                                      double max_step_width,
-                                     double inflation_radius)
+                                     double inflation_radius,
+                                     int    cache_size,
+                                     size_t cache_max_memory)
 : Heuristic(cell_size, num_angle_bins, PATH_COST),
-  ivpGrid(NULL),
   ivStepCost(step_cost),
   ivDiffAngleCost(diff_angle_cost),
   ivMaxStepWidth(max_step_width),
   ivInflationRadius(inflation_radius),
   ivGoalX(-1),
-  ivGoalY(-1)
-{};
+  ivGoalY(-1),
+  ivDistances(NULL),
+  ivDistanceFactor((1.0 + step_cost / max_step_width) / 1000.0),
+  ivAngleDiffCosts(num_angle_bins, 0.0),
+  ivPlanningCellMinX(0),
+  ivPlanningCellMinY(0),
+  ivCacheSize(cache_size),
+  ivCacheMaxMemory(cache_max_memory),
+  ivNumCacheHits(0),
+  ivNumCacheMisses(0),
+  ivMapVersion(0)
+{
+  if (ivDiffAngleCost > 0.0)
+  {
+    for (int diff_angle_disc = 0; diff_angle_disc < ivNumAngleBins;
+         ++diff_angle_disc)
+    {
+      // get the rotation independent from the rotation direction
+      double diff_angle = std::abs(angles::normalize_angle(
+          angle_cell_2_state(diff_angle_disc, ivNumAngleBins)));
+      ivAngleDiffCosts[diff_angle_disc] = diff_angle * ivDiffAngleCost;
+    }
+  }
+};
 
 
 PathCostHeuristic::~PathCostHeuristic()
-{
-  if (ivpGrid)
-    resetGrid();
-}
+{}
 
 
-double
-PathCostHeuristic::getHValue(const PlanningState& current,
-                             const PlanningState& to)
-const
+bool
+PathCostHeuristic::calculateDistances(const PlanningState& from,
+                                      const PlanningState& to)
 {
-  assert(ivGoalX >= 0 && ivGoalY >= 0);
-
-  if (current == to)
-    return 0.0;
+  assert(ivMapPtr);
 
   unsigned int from_x;
   unsigned int from_y;
-  // could be removed after more testing (then use ...noBounds... again)
-  ivMapPtr->worldToMapNoBounds(cell_2_state(current.getX(), ivCellSize),
-                               cell_2_state(current.getY(), ivCellSize),
+  ivMapPtr->worldToMapNoBounds(cell_2_state(from.getX(), ivCellSize),
+                               cell_2_state(from.getY(), ivCellSize),
                                from_x, from_y);
 
   unsigned int to_x;
   unsigned int to_y;
-  // could be removed after more testing (then use ...noBounds... again)
   ivMapPtr->worldToMapNoBounds(cell_2_state(to.getX(), ivCellSize),
                                cell_2_state(to.getY(), ivCellSize),
                                to_x, to_y);
 
-  // cast to unsigned int is safe since ivGoalX/ivGoalY are checked to be >= 0
-  if ((unsigned int)ivGoalX != to_x || (unsigned int)ivGoalY != to_y)
+  if ((int)to_x != ivGoalX || (int)to_y != ivGoalY)
   {
-    ROS_ERROR("PathCostHeuristic::getHValue to a different value than "
-              "precomputed, heuristic values will be wrong. You need to call "
-              "calculateDistances() before!");
+    ivGoalX = to_x;
+    ivGoalY = to_y;
+
+    distances_key_t key(ivMapVersion, std::make_pair(ivGoalX, ivGoalY));
+    std::map<distances_key_t, distances_cache_t::iterator>::iterator
+        cache_iter = ivDistancesCacheIndex.find(key);
+    if (cache_iter != ivDistancesCacheIndex.end())
+    {
+      // mark as most recently used
+      ivDistancesCache.splice(ivDistancesCache.begin(), ivDistancesCache,
+                              cache_iter->second);
+      ivDistancesPtr = cache_iter->second->second;
+      ivDistances = &(*ivDistancesPtr)[0];
+      ++ivNumCacheHits;
+    }
+    else
+    {
+      boost::shared_ptr<std::vector<int> > distances;
+      if (ivDistanceFieldPtr)
+      {
+        ivDistanceFieldPtr->compute(ivGoalX, ivGoalY);
+        distances.reset(new std::vector<int>);
+        ivDistanceFieldPtr->getDistances(distances.get());
+      }
+      else
+      {
+        ivGridSearchPtr->search(&ivGridRows[0], cvObstacleThreshold,
+                                ivGoalX, ivGoalY, from_x, from_y,
+                                SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+
+        // the grid search is reused for the next goal, so its distances are
+        // only copied if they are going to be cached, otherwise they are
+        // read from the grid search directly (see getDistance())
+        unsigned width = ivMapPtr->getInfo().width;
+        unsigned height = ivMapPtr->getInfo().height;
+        if (ivCacheSize > 0 &&
+            size_t(width) * height * sizeof(int) <= ivCacheMaxMemory)
+        {
+          distances.reset(new std::vector<int>(size_t(width) * height));
+          for (unsigned x = 0; x < width; ++x)
+          {
+            for (unsigned y = 0; y < height; ++y)
+            {
+              (*distances)[x * height + y] =
+                  ivGridSearchPtr->getlowerboundoncostfromstart_inmm(x, y);
+            }
+          }
+        }
+      }
+      ivDistancesPtr = distances;
+      if (distances)
+      {
+        ivDistances = &(*distances)[0];
+        cacheDistances(key, ivDistancesPtr);
+      }
+      else
+      {
+        ivDistances = NULL;
+      }
+      ++ivNumCacheMisses;
+    }
+    ROS_DEBUG("Path cost heuristic cache: %u hits, %u misses",
+              ivNumCacheHits, ivNumCacheMisses);
   }
-  assert((unsigned int)ivGoalX == to_x && (unsigned int)ivGoalY == to_y);
 
-  double dist = double(ivGridSearchPtr->getlowerboundoncostfromstart_inmm(
-      from_x, from_y)) / 1000.0;
+  return true;
+}
 
-  double expected_steps = dist / ivMaxStepWidth;
-  double diff_angle = 0.0;
-  if (ivDiffAngleCost > 0.0)
+
+void
+PathCostHeuristic::cacheDistances(const distances_key_t& key,
+                                  distances_ptr_t distances)
+{
+  if (ivCacheSize <= 0)
+    return;
+
+  ivDistancesCache.push_front(std::make_pair(key, distances));
+  ivDistancesCacheIndex[key] = ivDistancesCache.begin();
+
+  // evict the least recently used grids (all grids have the same size)
+  size_t grid_memory = distances->size() * sizeof(int);
+  while (ivDistancesCache.size() > size_t(ivCacheSize) ||
+         ivDistancesCache.size() * grid_memory > ivCacheMaxMemory)
   {
-    // get the number of bins between from.theta and to.theta
-    int diff_angle_disc = (
-        ((to.getTheta() - current.getTheta()) % ivNumAngleBins) +
-        ivNumAngleBins) % ivNumAngleBins;
-    // get the rotation independent from the rotation direction
-    diff_angle = std::abs(angles::normalize_angle(
-        angle_cell_2_state(diff_angle_disc, ivNumAngleBins)));
+    ivDistancesCacheIndex.erase(ivDistancesCache.back().first);
+    ivDistancesCache.pop_back();
   }
-
-  return (dist + expected_steps * ivStepCost + diff_angle * ivDiffAngleCost);
 }
 
 
 bool
-PathCostHeuristic::calculateDistances(const PlanningState& from,
-                                      const PlanningState& to)
+PathCostHeuristic::getPath(double x, double y,
+                           std::vector<std::pair<double, double> >* path)
+const
 {
-  assert(ivMapPtr);
+  path->clear();
+  if (ivGoalX < 0 || ivGoalY < 0)
+    return false;
 
-  unsigned int from_x;
-  unsigned int from_y;
-  ivMapPtr->worldToMapNoBounds(cell_2_state(from.getX(), ivCellSize),
-                               cell_2_state(from.getY(), ivCellSize),
-                               from_x, from_y);
+  unsigned int map_x, map_y;
+  if (!ivMapPtr->worldToMap(x, y, map_x, map_y))
+    return false;
 
-  unsigned int to_x;
-  unsigned int to_y;
-  ivMapPtr->worldToMapNoBounds(cell_2_state(to.getX(), ivCellSize),
-                               cell_2_state(to.getY(), ivCellSize),
-                               to_x, to_y);
+  int width = ivMapPtr->getInfo().width;
+  int height = ivMapPtr->getInfo().height;
+  int cur_x = map_x;
+  int cur_y = map_y;
+  int cur_dist = getDistance(size_t(cur_x) * height + cur_y);
+  if (cur_dist >= INFINITECOST)
+    return false;
 
-  if ((int)to_x != ivGoalX || (int)to_y != ivGoalY)
+  double wx, wy;
+  ivMapPtr->mapToWorld(cur_x, cur_y, wx, wy);
+  path->push_back(std::pair<double, double>(wx, wy));
+  // the 2D path costs strictly decrease towards the goal cell
+  while (cur_dist > 0)
   {
-    ivGoalX = to_x;
-    ivGoalY = to_y;
-    ivGridSearchPtr->search(ivpGrid, cvObstacleThreshold,
-                            ivGoalX, ivGoalY, from_x, from_y,
-                            SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+    int next_x = cur_x;
+    int next_y = cur_y;
+    int next_dist = cur_dist;
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+      for (int dy = -1; dy <= 1; ++dy)
+      {
+        int nx = cur_x + dx;
+        int ny = cur_y + dy;
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+          continue;
+        int dist = getDistance(size_t(nx) * height + ny);
+        if (dist < next_dist)
+        {
+          next_x = nx;
+          next_y = ny;
+          next_dist = dist;
+        }
+      }
+    }
+    // stalled before reaching the goal cell: the path would be truncated
+    if (next_dist == cur_dist)
+    {
+      path->clear();
+      return false;
+    }
+    cur_x = next_x;
+    cur_y = next_y;
+    cur_dist = next_dist;
+    ivMapPtr->mapToWorld(cur_x, cur_y, wx, wy);
+    path->push_back(std::pair<double, double>(wx, wy));
   }
 
   return true;
@@ -139,48 +249,107 @@ PathCostHeuristic::updateMap(gridmap_2d::GridMap2DPtr map)
 
   ivGoalX = ivGoalY = -1;
 
+  // the distances computed for the previous map are not valid any more
+  ++ivMapVersion;
+  ivDistancesPtr.reset();
+  ivDistances = NULL;
+  ivDistancesCache.clear();
+  ivDistancesCacheIndex.clear();
+
   unsigned width = ivMapPtr->getInfo().width;
   unsigned height = ivMapPtr->getInfo().height;
 
+  // map cells of all planning cells with their centers inside of the map
+  double origin_x = ivMapPtr->getInfo().origin.position.x;
+  double origin_y = ivMapPtr->getInfo().origin.position.y;
+  double resolution = ivMapPtr->getResolution();
+  ivPlanningCellMinX = state_2_cell(origin_x, ivCellSize);
+  ivPlanningCellMinY = state_2_cell(origin_y, ivCellSize);
+  int max_x = state_2_cell(origin_x + width * resolution, ivCellSize);
+  int max_y = state_2_cell(origin_y + height * resolution, ivCellSize);
+  ivMapRowOffsets.clear();
+  ivMapCellsY.clear();
+  for (int x = ivPlanningCellMinX; x <= max_x; ++x)
+  {
+    unsigned int map_x, map_y;
+    if (!ivMapPtr->worldToMap(cell_2_state(x, ivCellSize), origin_y,
+                              map_x, map_y))
+    {
+      // the table needs to be contiguous
+      if (ivMapRowOffsets.empty())
+      {
+        ++ivPlanningCellMinX;
+        continue;
+      }
+      break;
+    }
+    ivMapRowOffsets.push_back(size_t(map_x) * height);
+  }
+  for (int y = ivPlanningCellMinY; y <= max_y; ++y)
+  {
+    unsigned int map_x, map_y;
+    if (!ivMapPtr->worldToMap(origin_x, cell_2_state(y, ivCellSize),
+                              map_x, map_y))
+    {
+      if (ivMapCellsY.empty())
+      {
+        ++ivPlanningCellMinY;
+        continue;
+      }
+      break;
+    }
+    ivMapCellsY.push_back(map_y);
+  }
+
   if (ivGridSearchPtr)
     ivGridSearchPtr->destroy();
-  ivGridSearchPtr.reset(new SBPL2DGridSearch(width, height,
-                                             ivMapPtr->getResolution()));
-  if (ivpGrid)
-    resetGrid();
-  ivpGrid = new unsigned char* [width];
-
-  for (unsigned x = 0; x < width; ++x)
-    ivpGrid[x] = new unsigned char [height];
-  for (unsigned y = 0; y < height; ++y)
+  if (!ivDistanceFieldPtr)
   {
+    ivGridSearchPtr.reset(new SBPL2DGridSearch(width, height,
+                                               ivMapPtr->getResolution()));
+  }
+
+  // the buffer is only reallocated if the size of the map has changed
+  if (ivGrid.size() != size_t(width) * height)
+  {
+    ivGrid.resize(size_t(width) * height);
+    ivGridRows.resize(width);
     for (unsigned x = 0; x < width; ++x)
-    {
-      float dist = ivMapPtr->distanceMapAtCell(x,y);
-      if (dist < 0.0f)
-        ROS_ERROR("Distance map at %d %d out of bounds", x, y);
-      else if (dist <= ivInflationRadius)
-        ivpGrid[x][y] = 255;
-      else
-        ivpGrid[x][y] = 0;
-    }
+      ivGridRows[x] = &ivGrid[size_t(x) * height];
+  }
+  // inflate the obstacles by thresholding the distance map (stored as
+  // x / y = rows / columns, same as ivGrid) directly into the buffer
+  cv::Mat grid(width, height, CV_8UC1, &ivGrid[0]);
+  cv::compare(ivMapPtr->distanceMap(), ivInflationRadius, grid, cv::CMP_LE);
+  assert(grid.data == &ivGrid[0]);
+
+  if (ivDistanceFieldPtr)
+  {
+    ivDistanceFieldPtr->updateGrid(&ivGrid[0], width, height,
+                                   cvObstacleThreshold,
+                                   ivMapPtr->getResolution());
   }
 }
 
 
-void
-PathCostHeuristic::resetGrid()
+size_t
+PathCostHeuristic::mapIndexNoTable(const PlanningState& s) const
 {
-  CvSize size = ivMapPtr->size();
-  for (int x = 0; x < size.width; ++x)
+  unsigned int x;
+  unsigned int y;
+  if (!ivMapPtr->worldToMap(cell_2_state(s.getX(), ivCellSize),
+                            cell_2_state(s.getY(), ivCellSize),
+                            x, y))
   {
-    if (ivpGrid[x])
-    {
-      delete[] ivpGrid[x];
-      ivpGrid[x] = NULL;
-    }
+    return cvOutsideMap;
   }
-  delete[] ivpGrid;
-  ivpGrid = NULL;
+  return size_t(x) * ivMapPtr->getInfo().height + y;
+}
+
+
+void
+PathCostHeuristic::useGridDistanceField(int num_threads)
+{
+  ivDistanceFieldPtr.reset(new GridDistanceField(num_threads));
 }
 } // end of namespace
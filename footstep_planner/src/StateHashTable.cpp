@@ -0,0 +1,131 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/StateHashTable.h>
+
+#include <algorithm>
+#include <assert.h>
+
+
+namespace footstep_planner
+{
+const double StateHashTable::cvMaxLoadFactor = 0.5;
+
+
+StateHashTable::StateHashTable(unsigned int initial_size)
+: ivMask(0),
+  ivSize(0),
+  ivGrowThreshold(0),
+  ivNumLookups(0),
+  ivNumProbes(0),
+  ivMaxProbeLength(0),
+  ivNumResizes(0)
+{
+  // the number of slots has to be a power of two
+  size_t num_slots = 16;
+  while (num_slots < initial_size)
+    num_slots <<= 1;
+
+  Entry empty;
+  empty.key = 0;
+  empty.id = -1;
+  ivEntries.assign(num_slots, empty);
+  ivMask = num_slots - 1;
+  ivGrowThreshold = size_t(num_slots * cvMaxLoadFactor);
+}
+
+
+StateHashTable::~StateHashTable()
+{}
+
+
+void
+StateHashTable::insert(uint64_t key, int id)
+{
+  assert(id >= 0);
+  assert(find(key) == -1);
+
+  if (ivSize >= ivGrowThreshold)
+    grow();
+  insertNoGrow(key, id);
+  ++ivSize;
+}
+
+
+void
+StateHashTable::insertNoGrow(uint64_t key, int id)
+{
+  size_t i = key_hash(key) & ivMask;
+  while (ivEntries[i].id >= 0)
+    i = (i + 1) & ivMask;
+
+  ivEntries[i].key = key;
+  ivEntries[i].id = id;
+}
+
+
+void
+StateHashTable::grow()
+{
+  std::vector<Entry> old_entries;
+  old_entries.swap(ivEntries);
+
+  size_t num_slots = old_entries.size() * 2;
+  Entry empty;
+  empty.key = 0;
+  empty.id = -1;
+  ivEntries.assign(num_slots, empty);
+  ivMask = num_slots - 1;
+  ivGrowThreshold = size_t(num_slots * cvMaxLoadFactor);
+
+  std::vector<Entry>::const_iterator entry_iter;
+  for (entry_iter = old_entries.begin();
+       entry_iter != old_entries.end();
+       ++entry_iter)
+  {
+    if (entry_iter->id >= 0)
+      insertNoGrow(entry_iter->key, entry_iter->id);
+  }
+
+  ++ivNumResizes;
+  ROS_DEBUG("State hash table grown to %zu slots.", num_slots);
+}
+
+
+void
+StateHashTable::clear()
+{
+  Entry empty;
+  empty.key = 0;
+  empty.id = -1;
+  std::fill(ivEntries.begin(), ivEntries.end(), empty);
+  ivSize = 0;
+}
+
+
+void
+StateHashTable::resetStatistics()
+{
+  ivNumLookups = 0;
+  ivNumProbes = 0;
+  ivMaxProbeLength = 0;
+  ivNumResizes = 0;
+}
+}
@@ -0,0 +1,133 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/StepCostTable.h>
+
+#include <fstream>
+
+
+namespace footstep_planner
+{
+/// Identifies step cost table files ("FSCT").
+static const uint32_t cvFileMagic = 0x54435346;
+static const uint32_t cvFileVersion = 4;
+
+const uint16_t StepCostTable::cvUnknown;
+
+
+StepCostTable::StepCostTable()
+: ivRadius(-1),
+  ivNumAngleBins(0),
+  ivSignature(0)
+{}
+
+
+StepCostTable::~StepCostTable()
+{}
+
+
+size_t
+StepCostTable::numCosts(int radius, int num_angle_bins)
+{
+  if (radius < 0)
+    return 0;
+  size_t width = 2 * size_t(radius) + 1;
+  return size_t(num_angle_bins) * 2 * num_angle_bins * width * width;
+}
+
+
+void
+StepCostTable::resize(int radius, int num_angle_bins, uint64_t signature)
+{
+  ivRadius = radius;
+  ivNumAngleBins = num_angle_bins;
+  ivSignature = signature;
+
+  ivCosts.assign(numCosts(radius, num_angle_bins), cvUnknown);
+}
+
+
+bool
+StepCostTable::load(const std::string& filename, int num_angle_bins,
+                    uint64_t signature)
+{
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  uint32_t magic, version;
+  int32_t radius, file_num_angle_bins;
+  uint64_t file_signature;
+  file.read((char*)&magic, sizeof(magic));
+  file.read((char*)&version, sizeof(version));
+  file.read((char*)&radius, sizeof(radius));
+  file.read((char*)&file_num_angle_bins, sizeof(file_num_angle_bins));
+  file.read((char*)&file_signature, sizeof(file_signature));
+  if (!file.good() || magic != cvFileMagic || version != cvFileVersion ||
+      radius < 0 ||
+      file_num_angle_bins != num_angle_bins || file_signature != signature)
+  {
+    return false;
+  }
+
+  // the costs have to fill the rest of the file exactly (rejects truncated
+  // files before allocating the table)
+  std::streampos costs_begin = file.tellg();
+  file.seekg(0, std::ios::end);
+  std::streamoff costs_size = file.tellg() - costs_begin;
+  file.seekg(costs_begin);
+  size_t width = 2 * size_t(radius) + 1;
+  if (costs_size <= 0 || width > size_t(costs_size) / width ||
+      size_t(costs_size) != numCosts(radius, num_angle_bins) *
+                            sizeof(uint16_t))
+  {
+    return false;
+  }
+
+  resize(radius, num_angle_bins, signature);
+  file.read((char*)&ivCosts[0], ivCosts.size() * sizeof(uint16_t));
+  if (!file.good())
+  {
+    resize(-1, 0, 0);
+    return false;
+  }
+  return true;
+}
+
+
+bool
+StepCostTable::save(const std::string& filename) const
+{
+  std::ofstream file(filename.c_str(),
+                     std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+    return false;
+
+  int32_t radius = ivRadius;
+  int32_t num_angle_bins = ivNumAngleBins;
+  file.write((const char*)&cvFileMagic, sizeof(cvFileMagic));
+  file.write((const char*)&cvFileVersion, sizeof(cvFileVersion));
+  file.write((const char*)&radius, sizeof(radius));
+  file.write((const char*)&num_angle_bins, sizeof(num_angle_bins));
+  file.write((const char*)&ivSignature, sizeof(ivSignature));
+  file.write((const char*)&ivCosts[0], ivCosts.size() * sizeof(uint16_t));
+  return file.good();
+}
+}
@@ -0,0 +1,115 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <footstep_planner/WorkerPool.h>
+
+#include <boost/bind.hpp>
+
+
+namespace footstep_planner
+{
+WorkerPool::WorkerPool(int num_threads)
+: ivNumThreads(num_threads > 1 ? num_threads : 1),
+  ivTask(NULL),
+  ivNumTasks(0),
+  ivNextTask(0),
+  ivBatch(0),
+  ivNumActive(0),
+  ivStop(false)
+{
+  for (int i = 1; i < ivNumThreads; ++i)
+    ivThreads.create_thread(boost::bind(&WorkerPool::work, this));
+}
+
+
+WorkerPool::~WorkerPool()
+{
+  {
+    boost::mutex::scoped_lock lock(ivMutex);
+    ivStop = true;
+  }
+  ivBatchStarted.notify_all();
+  ivThreads.join_all();
+}
+
+
+void
+WorkerPool::run(size_t num_tasks, const boost::function<void (size_t)>& task)
+{
+  if (num_tasks == 0)
+    return;
+
+  {
+    boost::unique_lock<boost::mutex> lock(ivMutex);
+    // a worker woken up late may still be attached to the previous batch
+    while (ivNumActive > 0)
+      ivWorkersIdle.wait(lock);
+    ivTask = &task;
+    ivNumTasks = num_tasks;
+    ivNextTask = 0;
+    ++ivBatch;
+  }
+  ivBatchStarted.notify_all();
+
+  processBatch();
+
+  // all tasks have been taken, wait for the workers still processing theirs
+  boost::unique_lock<boost::mutex> lock(ivMutex);
+  while (ivNumActive > 0)
+    ivWorkersIdle.wait(lock);
+}
+
+
+void
+WorkerPool::work()
+{
+  unsigned int last_batch = 0;
+  boost::unique_lock<boost::mutex> lock(ivMutex);
+  while (true)
+  {
+    while (!ivStop && ivBatch == last_batch)
+      ivBatchStarted.wait(lock);
+    if (ivStop)
+      return;
+
+    last_batch = ivBatch;
+    ++ivNumActive;
+    lock.unlock();
+    processBatch();
+    lock.lock();
+    if (--ivNumActive == 0)
+      ivWorkersIdle.notify_all();
+  }
+}
+
+
+void
+WorkerPool::processBatch()
+{
+  while (true)
+  {
+    size_t i = __sync_fetch_and_add(&ivNextTask, 1);
+    if (i >= ivNumTasks)
+      return;
+    (*ivTask)(i);
+  }
+}
+}
@@ -0,0 +1,45 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/FootstepPlanner.h>
+#include <ros/ros.h>
+
+/**
+ * Computes the step cost table of the footsteps configured for the
+ * footstep planner (see FootstepPlannerEnvironment::computeStepCostTable())
+ * and writes it to the file given by the private parameter 'output'.
+ */
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "generate_step_cost_table");
+
+  ros::NodeHandle nh_private("~");
+  std::string filename;
+  double radius;
+  nh_private.param("output", filename, std::string("step_cost_table.bin"));
+  nh_private.param("radius", radius, 0.3);
+
+  footstep_planner::FootstepPlanner planner;
+  if (!planner.saveStepCostTable(filename, radius))
+    return 1;
+
+  ROS_INFO("Step cost table written to %s", filename.c_str());
+  return 0;
+}
@@ -80,6 +80,114 @@ collision_check(double x, double y, double theta, double height,
 }
 
 
+collision_shape::collision_shape(double height, double width, int accuracy)
+: height(height),
+  width(width),
+  r_o(sqrt(width*width + height*height) / 2.0),
+  accuracy(accuracy)
+{}
+
+
+bool
+collision_check(double x, double y, double theta_cos, double theta_sin,
+                const collision_shape& shape,
+                const gridmap_2d::GridMap2D& distance_map)
+{
+  // a sub-rectangle of the foot still to be checked
+  struct rectangle
+  {
+    double x, y;
+    double height, width;
+    double r_o;
+  };
+  // each split shrinks the rectangle to at most half of its size so the
+  // stack hardly ever grows beyond a few entries
+  static const int max_stack_size = 32;
+  rectangle stack[max_stack_size];
+  int stack_size = 1;
+  stack[0].x = x;
+  stack[0].y = y;
+  stack[0].height = shape.height;
+  stack[0].width = shape.width;
+  stack[0].r_o = shape.r_o;
+
+  const double resolution = distance_map.getResolution();
+  while (stack_size > 0)
+  {
+    const rectangle r = stack[--stack_size];
+
+    double d = distance_map.distanceMapAt(r.x, r.y);
+    if (d < 0.0) // if out of bounds => collision
+      return true;
+    d -= resolution;
+
+    if (d >= r.r_o)
+      continue;
+    else if (shape.accuracy == 0)
+      continue;
+
+    double h_half = r.height / 2.0f;
+    double w_half = r.width / 2.0f;
+    double r_i = std::min(w_half, h_half);
+
+    if (d <= r_i)
+      return true;
+    else if (shape.accuracy == 1)
+      return true;
+
+    double h_new;
+    double w_new;
+    double delta_x;
+    double delta_y;
+    if (r.width < r.height)
+    {
+      double h_clear = sqrt(d*d - w_half*w_half);
+      h_new = h_half - h_clear;
+      w_new = r.width;
+      delta_x = h_clear + h_new/2.0;
+      delta_y = 0.0;
+    }
+    else // footWidth >= footHeight
+    {
+      double w_clear = sqrt(d*d - h_half*h_half);
+      h_new = r.height;
+      w_new = w_half - w_clear;
+      delta_x = 0.0;
+      delta_y = w_clear + w_new/2.0;
+    }
+    double x_shift = theta_cos*delta_x - theta_sin*delta_y;
+    double y_shift = theta_sin*delta_x + theta_cos*delta_y;
+
+    rectangle child;
+    child.height = h_new;
+    child.width = w_new;
+    child.r_o = sqrt(w_new*w_new + h_new*h_new) / 2.0;
+    if (stack_size + 2 > max_stack_size)
+    {
+      // should not happen, fall back to checking the halves separately
+      collision_shape child_shape(h_new, w_new, shape.accuracy);
+      if (collision_check(r.x+x_shift, r.y+y_shift, theta_cos, theta_sin,
+                          child_shape, distance_map) ||
+          collision_check(r.x-x_shift, r.y-y_shift, theta_cos, theta_sin,
+                          child_shape, distance_map))
+      {
+        return true;
+      }
+      continue;
+    }
+    // same order as in the recursive version
+    child.x = r.x - x_shift;
+    child.y = r.y - y_shift;
+    stack[stack_size++] = child;
+    child.x = r.x + x_shift;
+    child.y = r.y + y_shift;
+    stack[stack_size++] = child;
+  }
+
+  return false;
+}
+
+
 bool
 pointWithinPolygon(int x, int y, const std::vector<std::pair<int, int> >& edges)
 {
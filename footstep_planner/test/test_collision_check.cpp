@@ -0,0 +1,112 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/helper.h>
+
+#include <gtest/gtest.h>
+#include <nav_msgs/OccupancyGrid.h>
+
+#include <stdlib.h>
+
+using footstep_planner::collision_check;
+using footstep_planner::collision_shape;
+
+
+// returns a uniformly distributed random number in [min, max]
+double
+randomValue(double min, double max, unsigned int* seed)
+{
+  return min + (max - min) * rand_r(seed) / double(RAND_MAX);
+}
+
+
+// compares the recursive collision check with the iterative one using the
+// precomputed foot shape for random foot poses on a random map
+void
+compareCollisionChecks(int accuracy, unsigned int seed)
+{
+  const int width = 100;
+  const int height = 80;
+  const double resolution = 0.01;
+  // the foot size of the Nao
+  const double foot_x = 0.16;
+  const double foot_y = 0.088;
+
+  nav_msgs::OccupancyGridPtr occupancy_map(new nav_msgs::OccupancyGrid());
+  occupancy_map->info.width = width;
+  occupancy_map->info.height = height;
+  occupancy_map->info.resolution = resolution;
+  occupancy_map->info.origin.orientation.w = 1.0;
+  occupancy_map->data.resize(width * height);
+  for (int i = 0; i < width * height; ++i)
+    occupancy_map->data[i] = rand_r(&seed) % 100 < 2 ? 100 : 0;
+  gridmap_2d::GridMap2D distance_map(occupancy_map);
+
+  collision_shape shape(foot_x, foot_y, accuracy);
+  int num_collisions = 0;
+  const int num_poses = 2000;
+  for (int i = 0; i < num_poses; ++i)
+  {
+    // includes poses partly outside of the map
+    double x = randomValue(-0.05, width * resolution + 0.05, &seed);
+    double y = randomValue(-0.05, height * resolution + 0.05, &seed);
+    double theta = randomValue(-M_PI, M_PI, &seed);
+
+    bool expected = collision_check(x, y, theta, foot_x, foot_y, accuracy,
+                                    distance_map);
+    EXPECT_EQ(expected, collision_check(x, y, cos(theta), sin(theta), shape,
+                                        distance_map))
+        << "pose (" << x << ", " << y << ", " << theta << ")";
+    if (expected)
+      ++num_collisions;
+  }
+  // both outcomes are covered
+  EXPECT_GT(num_collisions, 0);
+  EXPECT_LT(num_collisions, num_poses);
+}
+
+
+TEST(CollisionCheck, circumcircleMatchesRecursiveCheck)
+{
+  compareCollisionChecks(0, 1);
+  compareCollisionChecks(0, 2);
+}
+
+
+TEST(CollisionCheck, incircleMatchesRecursiveCheck)
+{
+  compareCollisionChecks(1, 1);
+  compareCollisionChecks(1, 2);
+}
+
+
+TEST(CollisionCheck, fullFootMatchesRecursiveCheck)
+{
+  compareCollisionChecks(2, 1);
+  compareCollisionChecks(2, 2);
+}
+
+
+int
+main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
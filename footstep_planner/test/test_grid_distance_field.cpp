@@ -0,0 +1,99 @@
+/*
+ * A footstep planner for humanoid robots
+ *
+ * Copyright 2010-2011 Johannes Garimort, Armin Hornung, University of Freiburg
+ * http://www.ros.org/wiki/footstep_planner
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <footstep_planner/GridDistanceField.h>
+
+#include <gtest/gtest.h>
+#include <sbpl/headers.h>
+
+#include <stdlib.h>
+#include <vector>
+
+using footstep_planner::GridDistanceField;
+
+
+// compares the distance field with the SBPL2DGridSearch on a random binary
+// grid (0: free, 255: occupied)
+void
+compareWithGridSearch(int num_threads, unsigned int seed)
+{
+  const int width = 60;
+  const int height = 45;
+  const unsigned char obstacle_threshold = 200;
+  const double resolution = 0.025;
+
+  std::vector<unsigned char> grid(width * height);
+  std::vector<unsigned char*> grid_rows(width);
+  for (int x = 0; x < width; ++x)
+  {
+    grid_rows[x] = &grid[x * height];
+    for (int y = 0; y < height; ++y)
+      grid[x * height + y] = rand_r(&seed) % 100 < 30 ? 255 : 0;
+  }
+  int goal_x = width / 2;
+  int goal_y = height / 2;
+  grid[goal_x * height + goal_y] = 0;
+
+  SBPL2DGridSearch grid_search(width, height, resolution);
+  grid_search.search(&grid_rows[0], obstacle_threshold, goal_x, goal_y,
+                     0, 0, SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+
+  GridDistanceField distance_field(num_threads);
+  distance_field.updateGrid(&grid[0], width, height, obstacle_threshold,
+                            resolution);
+  distance_field.compute(goal_x, goal_y);
+
+  int num_reachable = 0;
+  for (int x = 0; x < width; ++x)
+  {
+    for (int y = 0; y < height; ++y)
+    {
+      int expected = grid_search.getlowerboundoncostfromstart_inmm(x, y);
+      EXPECT_EQ(expected, distance_field.getDistance(x, y))
+          << "cell (" << x << ", " << y << ")";
+      if (expected < INFINITECOST)
+        ++num_reachable;
+    }
+  }
+  // the grid is not trivially blocked
+  EXPECT_GT(num_reachable, width * height / 4);
+}
+
+
+TEST(GridDistanceField, singleThreadMatchesGridSearch)
+{
+  compareWithGridSearch(1, 1);
+  compareWithGridSearch(1, 2);
+}
+
+
+TEST(GridDistanceField, multiThreadMatchesGridSearch)
+{
+  compareWithGridSearch(4, 1);
+  compareWithGridSearch(4, 2);
+}
+
+
+int
+main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}